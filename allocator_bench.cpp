@@ -0,0 +1,59 @@
+#include "optional.h"
+#include <benchmark/benchmark.h>
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+// Building records with optional string members: arena-resident records whose
+// payloads are constructed through uses-allocator construction, against
+// the same records on the global heap.
+
+namespace {
+constexpr const char* name_text = "a name that does not fit the small buffer";
+
+struct heap_record {
+  int id;
+  optional<std::string> name;
+};
+
+struct arena_record {
+  using allocator_type = std::pmr::polymorphic_allocator<>;
+
+  arena_record(int id_, const char* name_, allocator_type alloc)
+      : id{id_}, name{std::allocator_arg, alloc, name_} {}
+
+  arena_record(const arena_record& other, allocator_type alloc)
+      : id{other.id}, name{std::allocator_arg, alloc, other.name} {}
+
+  int id;
+  optional<std::pmr::string> name;
+};
+} // namespace
+
+static void BM_records_heap(benchmark::State& state) {
+  for (auto _ : state) {
+    std::vector<heap_record> records;
+    records.reserve(state.range(0));
+    for (int i = 0; i < state.range(0); ++i) {
+      records.push_back({i, optional<std::string>(in_place, name_text)});
+    }
+    benchmark::DoNotOptimize(records.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_records_heap)->Arg(1 << 10)->Arg(1 << 16);
+
+static void BM_records_arena(benchmark::State& state) {
+  std::vector<std::byte> buffer(state.range(0) * 256);
+  for (auto _ : state) {
+    std::pmr::monotonic_buffer_resource arena{buffer.data(), buffer.size()};
+    std::pmr::vector<arena_record> records{&arena};
+    records.reserve(state.range(0));
+    for (int i = 0; i < state.range(0); ++i) {
+      records.emplace_back(i, name_text);
+    }
+    benchmark::DoNotOptimize(records.data());
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_records_arena)->Arg(1 << 10)->Arg(1 << 16);
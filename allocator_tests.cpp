@@ -0,0 +1,128 @@
+#include "optional.h"
+#include "gtest/gtest.h"
+#include <memory_resource>
+#include <string>
+#include <vector>
+
+namespace {
+// Any allocation that escapes the arena goes to the default resource and
+// fails the test
+struct no_default_resource_guard {
+  no_default_resource_guard()
+      : old{std::pmr::set_default_resource(std::pmr::null_memory_resource())} {
+  }
+
+  no_default_resource_guard(const no_default_resource_guard&) = delete;
+  no_default_resource_guard&
+  operator=(const no_default_resource_guard&) = delete;
+
+  ~no_default_resource_guard() {
+    std::pmr::set_default_resource(old);
+  }
+
+  std::pmr::memory_resource* old;
+};
+
+constexpr const char* long_string =
+    "a string that is long enough to not fit into the small buffer";
+
+struct arena {
+  std::byte buffer[16 * 1024];
+  std::pmr::monotonic_buffer_resource resource{
+      buffer, sizeof(buffer), std::pmr::null_memory_resource()};
+};
+} // namespace
+
+TEST(allocator_testing, uses_allocator_trait) {
+  using alloc = std::pmr::polymorphic_allocator<char>;
+  EXPECT_TRUE((std::uses_allocator_v<optional<std::pmr::string>, alloc>));
+  EXPECT_FALSE((std::uses_allocator_v<optional<int>, alloc>));
+}
+
+TEST(allocator_testing, allocator_extended_ctors) {
+  arena a;
+  no_default_resource_guard g;
+  std::pmr::polymorphic_allocator<char> alloc{&a.resource};
+
+  optional<std::pmr::string> empty(std::allocator_arg, alloc);
+  EXPECT_FALSE(static_cast<bool>(empty));
+
+  optional<std::pmr::string> value(std::allocator_arg, alloc, long_string);
+  ASSERT_TRUE(static_cast<bool>(value));
+  EXPECT_EQ(long_string, *value);
+  EXPECT_EQ(&a.resource, value->get_allocator().resource());
+
+  optional<std::pmr::string> in_place_value(std::allocator_arg, alloc,
+                                            in_place, 3, 'x');
+  EXPECT_EQ("xxx", *in_place_value);
+
+  optional<std::pmr::string> copy(std::allocator_arg, alloc, value);
+  EXPECT_EQ(long_string, *copy);
+  EXPECT_EQ(&a.resource, copy->get_allocator().resource());
+
+  optional<std::pmr::string> moved(std::allocator_arg, alloc,
+                                   std::move(copy));
+  EXPECT_EQ(long_string, *moved);
+}
+
+// The value constructor takes part in overload resolution only for values
+// the payload can be built from, like the one without an allocator
+TEST(allocator_testing, value_ctor_constraints) {
+  using alloc = std::pmr::polymorphic_allocator<char>;
+  using optional1 = optional<std::pmr::string>;
+  EXPECT_TRUE((std::is_constructible_v<optional1, std::allocator_arg_t,
+                                       const alloc&, const char*>));
+  EXPECT_FALSE((std::is_constructible_v<optional1, std::allocator_arg_t,
+                                        const alloc&, int>));
+  EXPECT_FALSE((std::is_constructible_v<optional1, std::allocator_arg_t,
+                                        const alloc&, std::vector<int>>));
+  using optional2 = optional<std::vector<int>>;
+  EXPECT_TRUE((std::is_constructible_v<optional2, std::allocator_arg_t,
+                                       const alloc&, std::size_t>));
+}
+
+TEST(allocator_testing, emplace_with_allocator) {
+  arena a;
+  no_default_resource_guard g;
+  std::pmr::polymorphic_allocator<char> alloc{&a.resource};
+  optional<std::pmr::string> o;
+  o.emplace(std::allocator_arg, alloc, long_string);
+  EXPECT_EQ(long_string, *o);
+  EXPECT_EQ(&a.resource, o->get_allocator().resource());
+  const auto& const_alloc = alloc;
+  o.emplace(std::allocator_arg, const_alloc, 2, 'z');
+  EXPECT_EQ("zz", *o);
+  EXPECT_EQ(&a.resource, o->get_allocator().resource());
+}
+
+TEST(allocator_testing, pmr_container_propagates_arena) {
+  arena a;
+  no_default_resource_guard g;
+  std::pmr::vector<optional<std::pmr::string>> v{&a.resource};
+  v.reserve(8);
+  v.emplace_back(long_string);
+  v.emplace_back();
+  v.emplace_back(nullopt);
+  v.push_back(v.front());
+  v.emplace_back(in_place, 4, 'y');
+  ASSERT_EQ(5, v.size());
+  EXPECT_EQ(&a.resource, v[0]->get_allocator().resource());
+  EXPECT_FALSE(static_cast<bool>(v[1]));
+  EXPECT_FALSE(static_cast<bool>(v[2]));
+  EXPECT_EQ(long_string, *v[3]);
+  EXPECT_EQ(&a.resource, v[3]->get_allocator().resource());
+  EXPECT_EQ("yyyy", *v[4]);
+
+  std::pmr::vector<optional<std::pmr::string>> copy{v, &a.resource};
+  EXPECT_EQ(&a.resource, copy[0]->get_allocator().resource());
+}
+
+TEST(allocator_testing, nested_pmr_payload) {
+  arena a;
+  no_default_resource_guard g;
+  std::pmr::vector<optional<std::pmr::vector<std::pmr::string>>> v{
+      &a.resource};
+  v.emplace_back(in_place);
+  (*v[0]).emplace_back(long_string);
+  EXPECT_EQ(&a.resource, (*v[0])[0].get_allocator().resource());
+}
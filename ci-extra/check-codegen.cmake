@@ -0,0 +1,43 @@
+# Usage: cmake -DASM_FILE=<file.s> -P check-codegen.cmake
+#
+# Checks the x86-64 assembly of codegen_probes.cpp: each `probe_*` function must
+# not call anything and must not touch memory, which means that its optional
+# arguments and results are passed in registers.
+
+if (NOT ASM_FILE)
+  message(FATAL_ERROR "ASM_FILE is not set")
+endif()
+
+file(STRINGS "${ASM_FILE}" lines)
+
+set(current "")
+set(probes "")
+set(failures "")
+foreach (line IN LISTS lines)
+  if (line MATCHES "^(probe_[A-Za-z0-9_]+):")
+    set(current "${CMAKE_MATCH_1}")
+    list(APPEND probes "${current}")
+  elseif (current STREQUAL "")
+    continue()
+  elseif (line MATCHES "^[ \t]*\\.(cfi_endproc|size)")
+    set(current "")
+  elseif (line MATCHES "^[ \t]*call")
+    list(APPEND failures "${current}: call in `${line}`")
+  elseif (line MATCHES "^[ \t]*j[a-z]*[ \t]+[^.]")
+    list(APPEND failures "${current}: tail call in `${line}`")
+  elseif (line MATCHES "^[ \t]*[a-z].*\\(%")
+    list(APPEND failures "${current}: memory access in `${line}`")
+  endif()
+endforeach()
+
+list(LENGTH probes probe_count)
+if (probe_count EQUAL 0)
+  message(FATAL_ERROR "no probe_* functions found in ${ASM_FILE}")
+endif()
+
+if (failures)
+  list(JOIN failures "\n" report)
+  message(FATAL_ERROR "optional codegen regressed:\n${report}")
+endif()
+
+message(STATUS "${probe_count} probes passed: ${probes}")
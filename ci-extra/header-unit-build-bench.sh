@@ -0,0 +1,94 @@
+#!/bin/bash
+# Usage: ci-extra/header-unit-build-bench.sh [translation units, default 300]
+#
+# Compiles generated translation units that use optional in two ways,
+# `#include "optional.h"` and the header unit `import "optional.h";`, and
+# prints the wall time of each, the header unit build included. $CXX selects
+# the compiler, g++ and clang++ are supported. The header_unit_probe CMake
+# target builds and imports the same header unit with g++.
+set -euo pipefail
+IFS=$' \t\n'
+
+SCRIPT_DIR="$( cd "$( dirname "${BASH_SOURCE[0]}" )" && pwd )"
+REPO_DIR="$(dirname "${SCRIPT_DIR}")"
+COUNT=${1:-300}
+CXX=${CXX:-g++}
+JOBS=$(nproc)
+WORK=$(mktemp -d)
+trap 'rm -rf "${WORK}"' EXIT
+
+if "${CXX}" --version | grep -q clang; then
+  IS_CLANG=1
+else
+  IS_CLANG=0
+fi
+
+# generate <dir> <first line of every translation unit>
+generate() {
+  mkdir -p "$1"
+  for ((i = 0; i < COUNT; ++i)); do
+    cat > "$1/tu${i}.cpp" <<EOF
+$2
+
+optional<long> parse_${i}(long x) {
+  if (x < 0) {
+    return nullopt;
+  }
+  return x * ${i};
+}
+
+long use_${i}(long x) {
+  optional<long> a = parse_${i}(x), b;
+  b = a;
+  return a == b && b ? *b : 0;
+}
+EOF
+  done
+}
+
+# compile_all <dir> <flags...>, from inside <dir> so that gcm.cache is found
+compile_all() {
+  local dir=$1
+  shift
+  (cd "${dir}" && ls tu*.cpp | xargs -P"${JOBS}" -I{} \
+      "${CXX}" -std=c++20 -O2 -I"${REPO_DIR}" "$@" -c {} -o {}.o)
+}
+
+build_textual() {
+  compile_all "${WORK}/textual"
+}
+
+build_header_unit() {
+  local dir="${WORK}/header-unit"
+  if [[ ${IS_CLANG} == 1 ]]; then
+    (cd "${dir}" && "${CXX}" -std=c++20 -O2 -I"${REPO_DIR}" \
+        -fmodule-header=user -x c++-header optional.h -o optional.pcm)
+    compile_all "${dir}" -fmodule-file="${dir}/optional.pcm"
+  else
+    (cd "${dir}" && "${CXX}" -std=c++20 -O2 -fmodules-ts -I"${REPO_DIR}" \
+        -fmodule-header=user -x c++-header optional.h)
+    compile_all "${dir}" -fmodules-ts
+  fi
+}
+
+# measure <name> <function>
+measure() {
+  local start end
+  start=$(date +%s.%N)
+  if "$2" > "${WORK}/$1.log" 2>&1; then
+    end=$(date +%s.%N)
+    awk -v name="$1" -v s="${start}" -v e="${end}" \
+        'BEGIN { printf "%-14s %8.2f s\n", name, e - s }'
+  else
+    printf '%-14s   failed:\n' "$1"
+    head -n 5 "${WORK}/$1.log" | sed 's/^/    /'
+  fi
+}
+
+generate "${WORK}/textual" '#include "optional.h"'
+generate "${WORK}/header-unit" 'import "optional.h";'
+
+echo "${COUNT} translation units, ${JOBS} jobs," \
+     "$("${CXX}" --version | head -n 1)"
+measure textual build_textual
+measure header-unit build_header_unit
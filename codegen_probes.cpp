@@ -0,0 +1,46 @@
+// Compiled to assembly only and checked by ci-extra/check-codegen.cmake: every
+// `probe_*` function must take and return its optionals in registers and must
+// not call anything, i.e. `optional` of a trivial payload is zero-overhead.
+
+#include "optional.h"
+
+extern "C" {
+int probe_deref_or(optional<int> a) {
+  return a ? *a : -1;
+}
+
+optional<int> probe_make(int x) {
+  return optional<int>(x);
+}
+
+optional<int> probe_make_empty() {
+  return nullopt;
+}
+
+optional<double> probe_pass_double(optional<double> a) {
+  return a;
+}
+
+optional<long long> probe_copy_assign(optional<long long> a,
+                                      optional<long long> b) {
+  a = b;
+  return a;
+}
+
+optional<int> probe_reset(optional<int> a) {
+  a.reset();
+  return a;
+}
+
+bool probe_equal(optional<int> a, optional<int> b) {
+  return a == b;
+}
+
+bool probe_less(optional<int> a, optional<int> b) {
+  return a < b;
+}
+
+bool probe_has_value(optional<char> a) {
+  return a.has_value();
+}
+}
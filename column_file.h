@@ -0,0 +1,383 @@
+#pragma once
+
+#include "optional.h"
+#include "posix_error.h"
+
+#include <cerrno>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <fcntl.h>
+#include <span>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <system_error>
+#include <unistd.h>
+#include <utility>
+#include <vector>
+
+/*******************************************************************************
+ *                                 File layout                                 *
+ *******************************************************************************/
+
+// A nullable column is stored as
+//
+//   [column_header][pad to 64][values: row_count * sizeof(T)][pad to 64]
+//   [validity: ceil(row_count / 64) 64-bit words, bit i % 64 of word i / 64]
+//
+// Null rows keep a zero-filled value slot, so row i is always at
+// `values_offset + i * sizeof(T)`. Both sections are 64-byte aligned, which
+// lets a mapped file be read in place. Integers are stored in native byte
+// order, `byte_order` tells readers on the other endianness to reject the file.
+
+struct column_file_error : std::runtime_error {
+  using std::runtime_error::runtime_error;
+};
+
+enum class column_kind : std::uint32_t {
+  unsigned_integer = 1,
+  signed_integer = 2,
+  floating_point = 3,
+};
+
+struct column_header {
+  static constexpr char expected_magic[8] = {'O', 'P', 'T', 'C',
+                                             'O', 'L', '\0', '\0'};
+  static constexpr std::uint32_t current_version = 1;
+  static constexpr std::uint32_t native_byte_order = 0x01020304;
+
+  char magic[8];
+  std::uint32_t version;
+  std::uint32_t byte_order;
+  column_kind kind;
+  std::uint32_t value_size;
+  std::uint64_t row_count;
+  std::uint64_t values_offset;
+  std::uint64_t validity_offset;
+  std::uint64_t values_checksum;
+  std::uint64_t validity_checksum;
+};
+
+static_assert(sizeof(column_header) == 64);
+
+namespace detail {
+inline constexpr std::size_t column_alignment = 64;
+
+template <typename T>
+constexpr column_kind column_kind_of() {
+  static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>,
+                "columns hold integers or floating point values");
+  if constexpr (std::is_floating_point_v<T>) {
+    return column_kind::floating_point;
+  } else if constexpr (std::is_signed_v<T>) {
+    return column_kind::signed_integer;
+  } else {
+    return column_kind::unsigned_integer;
+  }
+}
+
+constexpr std::uint64_t align_up(std::uint64_t n, std::uint64_t alignment) {
+  return (n + alignment - 1) / alignment * alignment;
+}
+
+constexpr std::uint64_t validity_words(std::uint64_t rows) {
+  return (rows + 63) / 64;
+}
+
+// 64-bit FNV-1a, fed incrementally while the column is written
+struct fnv1a {
+  std::uint64_t state = 14695981039346656037ull;
+
+  void update(const void* data, std::size_t size) noexcept {
+    auto bytes = static_cast<const unsigned char*>(data);
+    for (std::size_t i = 0; i < size; ++i) {
+      state = (state ^ bytes[i]) * 1099511628211ull;
+    }
+  }
+};
+
+inline void write_fully(int fd, const void* data, std::size_t size,
+                        off_t offset) {
+  auto bytes = static_cast<const char*>(data);
+  while (size > 0) {
+    ssize_t written = ::pwrite(fd, bytes, size, offset);
+    if (written < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      throw_errno("pwrite");
+    }
+    bytes += written;
+    size -= static_cast<std::size_t>(written);
+    offset += written;
+  }
+}
+} // namespace detail
+
+/*******************************************************************************
+ *                               Streaming writer                              *
+ *******************************************************************************/
+
+// Appends rows one by one; only the validity bitmap (one bit per row) is kept
+// in memory. The header is written last, so an unfinished file never passes
+// validation.
+template <typename T>
+class column_writer {
+public:
+  explicit column_writer(const std::string& path) {
+    fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0) {
+      detail::throw_errno("open " + path);
+    }
+    buffer.reserve(buffer_rows);
+  }
+
+  column_writer(const column_writer&) = delete;
+  column_writer& operator=(const column_writer&) = delete;
+
+  ~column_writer() {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+
+  void push_back(const optional<T>& row) {
+    if (row) {
+      push_back(*row);
+    } else {
+      push_null();
+    }
+  }
+
+  void push_back(T value) {
+    if (rows % 64 == 0) {
+      validity.push_back(0);
+    }
+    validity.back() |= std::uint64_t{1} << (rows % 64);
+    append(value);
+  }
+
+  void push_null() {
+    if (rows % 64 == 0) {
+      validity.push_back(0);
+    }
+    append(T{});
+  }
+
+  std::uint64_t size() const noexcept {
+    return rows;
+  }
+
+  // Writes the validity bitmap and the header and closes the file
+  void finish() {
+    flush();
+    column_header header{};
+    std::memcpy(header.magic, column_header::expected_magic,
+                sizeof(header.magic));
+    header.version = column_header::current_version;
+    header.byte_order = column_header::native_byte_order;
+    header.kind = detail::column_kind_of<T>();
+    header.value_size = sizeof(T);
+    header.row_count = rows;
+    header.values_offset = values_offset;
+    header.validity_offset = detail::align_up(
+        values_offset + rows * sizeof(T), detail::column_alignment);
+    header.values_checksum = values_checksum.state;
+
+    detail::fnv1a validity_checksum;
+    validity_checksum.update(validity.data(),
+                             validity.size() * sizeof(std::uint64_t));
+    header.validity_checksum = validity_checksum.state;
+
+    detail::write_fully(fd, validity.data(),
+                        validity.size() * sizeof(std::uint64_t),
+                        static_cast<off_t>(header.validity_offset));
+    detail::write_fully(fd, &header, sizeof(header), 0);
+    if (::ftruncate(fd, static_cast<off_t>(header.validity_offset +
+                                           validity.size() *
+                                               sizeof(std::uint64_t))) != 0) {
+      detail::throw_errno("ftruncate");
+    }
+    if (::close(std::exchange(fd, -1)) != 0) {
+      detail::throw_errno("close");
+    }
+  }
+
+private:
+  static constexpr std::size_t buffer_rows = 64 * 1024 / sizeof(T);
+  static constexpr std::uint64_t values_offset =
+      detail::align_up(sizeof(column_header), detail::column_alignment);
+
+  void append(T value) {
+    buffer.push_back(value);
+    ++rows;
+    if (buffer.size() == buffer_rows) {
+      flush();
+    }
+  }
+
+  void flush() {
+    std::size_t bytes = buffer.size() * sizeof(T);
+    values_checksum.update(buffer.data(), bytes);
+    auto offset = static_cast<off_t>(values_offset + flushed * sizeof(T));
+    detail::write_fully(fd, buffer.data(), bytes, offset);
+    flushed += buffer.size();
+    buffer.clear();
+  }
+
+  int fd{-1};
+  std::uint64_t rows{0};
+  std::uint64_t flushed{0};
+  std::vector<T> buffer;
+  std::vector<std::uint64_t> validity;
+  detail::fnv1a values_checksum;
+};
+
+/*******************************************************************************
+ *                             Memory-mapped view                              *
+ *******************************************************************************/
+
+// Read-only view of a column file. Rows are read straight from the mapping,
+// nothing is deserialized up front.
+template <typename T>
+class column_view {
+public:
+  explicit column_view(const std::string& path) {
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+      detail::throw_errno("open " + path);
+    }
+    struct stat st {};
+    if (::fstat(fd, &st) != 0) {
+      ::close(fd);
+      detail::throw_errno("fstat " + path);
+    }
+    mapped_size = static_cast<std::size_t>(st.st_size);
+    if (mapped_size < sizeof(column_header)) {
+      ::close(fd);
+      throw column_file_error(path + ": file is too small");
+    }
+    void* p = ::mmap(nullptr, mapped_size, PROT_READ, MAP_SHARED, fd, 0);
+    ::close(fd);
+    if (p == MAP_FAILED) {
+      detail::throw_errno("mmap " + path);
+    }
+    mapping = static_cast<const char*>(p);
+    try {
+      validate(path);
+    } catch (...) {
+      ::munmap(const_cast<char*>(mapping), mapped_size);
+      throw;
+    }
+  }
+
+  column_view(column_view&& other) noexcept
+      : mapping{std::exchange(other.mapping, nullptr)},
+        mapped_size{std::exchange(other.mapped_size, 0)},
+        header{other.header}, values_data{other.values_data},
+        validity_data{other.validity_data} {}
+
+  column_view& operator=(column_view&& other) noexcept {
+    column_view tmp{std::move(other)};
+    std::swap(mapping, tmp.mapping);
+    std::swap(mapped_size, tmp.mapped_size);
+    std::swap(header, tmp.header);
+    std::swap(values_data, tmp.values_data);
+    std::swap(validity_data, tmp.validity_data);
+    return *this;
+  }
+
+  ~column_view() {
+    if (mapping != nullptr) {
+      ::munmap(const_cast<char*>(mapping), mapped_size);
+    }
+  }
+
+  std::uint64_t size() const noexcept {
+    return header.row_count;
+  }
+
+  bool is_valid(std::uint64_t row) const noexcept {
+    return (validity_data[row / 64] >> (row % 64)) & 1;
+  }
+
+  optional<T> operator[](std::uint64_t row) const noexcept {
+    if (!is_valid(row)) {
+      return nullopt;
+    }
+    return values_data[row];
+  }
+
+  optional<T> at(std::uint64_t row) const {
+    if (row >= size()) {
+      throw std::out_of_range("column_view::at");
+    }
+    return (*this)[row];
+  }
+
+  // Raw value slots, zero for null rows
+  std::span<const T> values() const noexcept {
+    return {values_data, header.row_count};
+  }
+
+  std::span<const std::uint64_t> validity() const noexcept {
+    return {validity_data, detail::validity_words(header.row_count)};
+  }
+
+  // Checksums cover the whole file, so they are only checked on request
+  bool verify_checksums() const noexcept {
+    detail::fnv1a values_checksum, validity_checksum;
+    values_checksum.update(values_data, header.row_count * sizeof(T));
+    validity_checksum.update(validity_data, detail::validity_words(
+                                                header.row_count) *
+                                                sizeof(std::uint64_t));
+    return values_checksum.state == header.values_checksum &&
+           validity_checksum.state == header.validity_checksum;
+  }
+
+private:
+  void validate(const std::string& path) {
+    std::memcpy(&header, mapping, sizeof(header));
+    auto fail = [&](const char* reason) {
+      throw column_file_error(path + ": " + reason);
+    };
+    if (std::memcmp(header.magic, column_header::expected_magic,
+                    sizeof(header.magic)) != 0) {
+      fail("not a column file or not finished");
+    }
+    if (header.version != column_header::current_version) {
+      fail("unsupported version");
+    }
+    if (header.byte_order != column_header::native_byte_order) {
+      fail("foreign byte order");
+    }
+    if (header.kind != detail::column_kind_of<T>() ||
+        header.value_size != sizeof(T)) {
+      fail("column type does not match");
+    }
+    // Every field may be garbage: bound the row count by the space between
+    // the offsets with divisions, so that no product or sum can wrap
+    if (header.values_offset % detail::column_alignment != 0 ||
+        header.validity_offset % detail::column_alignment != 0 ||
+        header.values_offset < sizeof(column_header) ||
+        header.validity_offset < header.values_offset ||
+        header.validity_offset > mapped_size ||
+        header.row_count >
+            (header.validity_offset - header.values_offset) / sizeof(T) ||
+        detail::validity_words(header.row_count) >
+            (mapped_size - header.validity_offset) / sizeof(std::uint64_t)) {
+      fail("corrupted layout");
+    }
+    values_data = reinterpret_cast<const T*>(mapping + header.values_offset);
+    validity_data = reinterpret_cast<const std::uint64_t*>(
+        mapping + header.validity_offset);
+  }
+
+  const char* mapping{nullptr};
+  std::size_t mapped_size{0};
+  column_header header{};
+  const T* values_data{nullptr};
+  const std::uint64_t* validity_data{nullptr};
+};
@@ -0,0 +1,128 @@
+#include "column_file.h"
+#include <benchmark/benchmark.h>
+#include <filesystem>
+#include <fstream>
+#include <random>
+
+// Reloading a nullable column: element-by-element deserialization into
+// `std::vector<optional<T>>` against the memory-mapped `column_view`.
+
+namespace {
+constexpr std::uint64_t column_rows = 4'000'000;
+
+struct column_files {
+  column_files() {
+    auto dir = std::filesystem::temp_directory_path();
+    mapped = (dir / ("column_bench_" + std::to_string(::getpid()))).string();
+    stream = mapped + ".stream";
+
+    std::mt19937_64 rng(42);
+    column_writer<double> writer(mapped);
+    std::ofstream out(stream, std::ios::binary);
+    for (std::uint64_t i = 0; i < column_rows; ++i) {
+      bool valid = rng() % 10 != 0;
+      double value = static_cast<double>(i);
+      char flag = valid ? 1 : 0;
+      out.write(&flag, 1);
+      if (valid) {
+        out.write(reinterpret_cast<const char*>(&value), sizeof(value));
+        writer.push_back(value);
+      } else {
+        writer.push_null();
+      }
+    }
+    writer.finish();
+  }
+
+  ~column_files() {
+    std::filesystem::remove(mapped);
+    std::filesystem::remove(stream);
+  }
+
+  std::string mapped;
+  std::string stream;
+};
+
+const column_files& files() {
+  static column_files instance;
+  return instance;
+}
+
+std::vector<optional<double>> load_stream(const std::string& path) {
+  std::vector<optional<double>> result;
+  result.reserve(column_rows);
+  std::ifstream in(path, std::ios::binary);
+  char flag;
+  while (in.read(&flag, 1)) {
+    if (flag) {
+      double value;
+      in.read(reinterpret_cast<char*>(&value), sizeof(value));
+      result.emplace_back(value);
+    } else {
+      result.emplace_back();
+    }
+  }
+  return result;
+}
+
+template <typename Column>
+double sum_all(const Column& column, std::uint64_t rows) {
+  double sum = 0;
+  for (std::uint64_t i = 0; i < rows; ++i) {
+    auto row = column[i];
+    if (row) {
+      sum += *row;
+    }
+  }
+  return sum;
+}
+
+template <typename Column>
+double sum_random(const Column& column, std::uint64_t rows) {
+  std::mt19937_64 rng(7);
+  double sum = 0;
+  for (int i = 0; i < 100'000; ++i) {
+    auto row = column[rng() % rows];
+    if (row) {
+      sum += *row;
+    }
+  }
+  return sum;
+}
+} // namespace
+
+static void BM_column_stream_load_and_scan(benchmark::State& state) {
+  for (auto _ : state) {
+    auto column = load_stream(files().stream);
+    benchmark::DoNotOptimize(sum_all(column, column.size()));
+  }
+  state.SetItemsProcessed(state.iterations() * column_rows);
+}
+BENCHMARK(BM_column_stream_load_and_scan)->Unit(benchmark::kMillisecond);
+
+static void BM_column_mmap_open_and_scan(benchmark::State& state) {
+  for (auto _ : state) {
+    column_view<double> column(files().mapped);
+    benchmark::DoNotOptimize(sum_all(column, column.size()));
+  }
+  state.SetItemsProcessed(state.iterations() * column_rows);
+}
+BENCHMARK(BM_column_mmap_open_and_scan)->Unit(benchmark::kMillisecond);
+
+static void BM_column_stream_load_and_random_access(benchmark::State& state) {
+  for (auto _ : state) {
+    auto column = load_stream(files().stream);
+    benchmark::DoNotOptimize(sum_random(column, column.size()));
+  }
+}
+BENCHMARK(BM_column_stream_load_and_random_access)
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_column_mmap_open_and_random_access(benchmark::State& state) {
+  for (auto _ : state) {
+    column_view<double> column(files().mapped);
+    benchmark::DoNotOptimize(sum_random(column, column.size()));
+  }
+}
+BENCHMARK(BM_column_mmap_open_and_random_access)
+    ->Unit(benchmark::kMillisecond);
@@ -0,0 +1,176 @@
+#include "column_file.h"
+#include "gtest/gtest.h"
+#include <filesystem>
+#include <fstream>
+
+namespace {
+struct temp_file {
+  temp_file()
+      : path{(std::filesystem::temp_directory_path() /
+              ("column_file_test_" + std::to_string(::getpid()) + "_" +
+               std::to_string(counter++)))
+                 .string()} {}
+
+  temp_file(const temp_file&) = delete;
+  temp_file& operator=(const temp_file&) = delete;
+
+  ~temp_file() {
+    std::filesystem::remove(path);
+  }
+
+  std::string path;
+
+  static inline int counter = 0;
+};
+} // namespace
+
+TEST(column_file_testing, round_trip) {
+  temp_file file;
+  {
+    column_writer<int> writer(file.path);
+    writer.push_back(1);
+    writer.push_null();
+    writer.push_back(optional<int>(3));
+    writer.push_back(optional<int>());
+    writer.finish();
+  }
+  column_view<int> view(file.path);
+  ASSERT_EQ(4, view.size());
+  EXPECT_EQ(optional<int>(1), view[0]);
+  EXPECT_FALSE(static_cast<bool>(view[1]));
+  EXPECT_EQ(optional<int>(3), view[2]);
+  EXPECT_FALSE(static_cast<bool>(view.at(3)));
+  EXPECT_THROW(view.at(4), std::out_of_range);
+  EXPECT_EQ(0, view.values()[1]);
+  EXPECT_TRUE(view.verify_checksums());
+}
+
+TEST(column_file_testing, many_rows) {
+  temp_file file;
+  constexpr std::uint64_t rows = 100'000;
+  {
+    column_writer<double> writer(file.path);
+    for (std::uint64_t i = 0; i < rows; ++i) {
+      if (i % 3 == 0) {
+        writer.push_null();
+      } else {
+        writer.push_back(static_cast<double>(i) / 2);
+      }
+    }
+    writer.finish();
+  }
+  column_view<double> view(file.path);
+  ASSERT_EQ(rows, view.size());
+  EXPECT_EQ(reinterpret_cast<std::uintptr_t>(view.values().data()) % 64, 0);
+  for (std::uint64_t i = 0; i < rows; ++i) {
+    if (i % 3 == 0) {
+      ASSERT_FALSE(static_cast<bool>(view[i]));
+    } else {
+      ASSERT_EQ(static_cast<double>(i) / 2, *view[i]);
+    }
+  }
+  EXPECT_TRUE(view.verify_checksums());
+}
+
+TEST(column_file_testing, empty_column) {
+  temp_file file;
+  {
+    column_writer<std::uint16_t> writer(file.path);
+    writer.finish();
+  }
+  column_view<std::uint16_t> view(file.path);
+  EXPECT_EQ(0, view.size());
+  EXPECT_TRUE(view.verify_checksums());
+}
+
+TEST(column_file_testing, unfinished_file_is_rejected) {
+  temp_file file;
+  {
+    column_writer<int> writer(file.path);
+    for (int i = 0; i < 100; ++i) {
+      writer.push_back(i);
+    }
+  }
+  EXPECT_THROW(column_view<int>{file.path}, column_file_error);
+}
+
+TEST(column_file_testing, type_mismatch_is_rejected) {
+  temp_file file;
+  {
+    column_writer<int> writer(file.path);
+    writer.push_back(1);
+    writer.finish();
+  }
+  EXPECT_THROW(column_view<float>{file.path}, column_file_error);
+  EXPECT_THROW(column_view<unsigned>{file.path}, column_file_error);
+  EXPECT_THROW(column_view<long>{file.path}, column_file_error);
+}
+
+TEST(column_file_testing, corruption_is_detected) {
+  temp_file file;
+  {
+    column_writer<int> writer(file.path);
+    writer.push_back(1);
+    writer.push_back(2);
+    writer.finish();
+  }
+  {
+    std::fstream f(file.path, std::ios::in | std::ios::out | std::ios::binary);
+    f.seekp(sizeof(column_header));
+    f.put(42);
+  }
+  column_view<int> view(file.path);
+  EXPECT_FALSE(view.verify_checksums());
+}
+
+namespace {
+template <typename Field>
+void patch_header(const std::string& path, Field column_header::*field,
+                  Field value) {
+  column_header header;
+  std::fstream f(path, std::ios::in | std::ios::out | std::ios::binary);
+  f.read(reinterpret_cast<char*>(&header), sizeof(header));
+  header.*field = value;
+  f.seekp(0);
+  f.write(reinterpret_cast<const char*>(&header), sizeof(header));
+}
+} // namespace
+
+TEST(column_file_testing, corrupted_header_is_rejected) {
+  constexpr std::uint64_t huge = ~std::uint64_t{0};
+  temp_file file;
+  auto write = [&] {
+    column_writer<double> writer(file.path);
+    for (int i = 0; i < 10; ++i) {
+      writer.push_back(i);
+    }
+    writer.finish();
+  };
+
+  write();
+  patch_header(file.path, &column_header::row_count, huge);
+  EXPECT_THROW(column_view<double>{file.path}, column_file_error);
+
+  write();
+  patch_header(file.path, &column_header::row_count, huge / sizeof(double));
+  EXPECT_THROW(column_view<double>{file.path}, column_file_error);
+
+  write();
+  patch_header(file.path, &column_header::row_count, std::uint64_t{17});
+  EXPECT_THROW(column_view<double>{file.path}, column_file_error);
+
+  write();
+  patch_header(file.path, &column_header::validity_offset, huge - 63);
+  EXPECT_THROW(column_view<double>{file.path}, column_file_error);
+
+  write();
+  patch_header(file.path, &column_header::values_offset, huge - 63);
+  EXPECT_THROW(column_view<double>{file.path}, column_file_error);
+
+  write();
+  EXPECT_EQ(10, column_view<double>{file.path}.size());
+}
+
+TEST(column_file_testing, missing_file) {
+  EXPECT_THROW(column_view<int>{"/nonexistent/column"}, std::system_error);
+}
@@ -0,0 +1,317 @@
+#pragma once
+
+#include "optional.h"
+
+#include <atomic>
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <utility>
+
+namespace detail {
+/*******************************************************************************
+ *                               Shared payloads                               *
+ *******************************************************************************/
+
+template <bool thread_safe>
+struct cow_counter;
+
+template <>
+struct cow_counter<false> {
+  std::size_t count{1};
+
+  void acquire() noexcept {
+    ++count;
+  }
+
+  // Returns true if this was the last reference
+  bool release() noexcept {
+    return --count == 0;
+  }
+
+  std::size_t load() const noexcept {
+    return count;
+  }
+};
+
+// Same ordering as `std::shared_ptr`: taking a reference needs no ordering,
+// dropping one publishes our writes to whoever deletes the payload
+template <>
+struct cow_counter<true> {
+  std::atomic<std::size_t> count{1};
+
+  void acquire() noexcept {
+    count.fetch_add(1, std::memory_order_relaxed);
+  }
+
+  bool release() noexcept {
+    return count.fetch_sub(1, std::memory_order_acq_rel) == 1;
+  }
+
+  // Acquire, so that a count of 1 also means the writes of the former owners
+  // are visible before we start mutating in place
+  std::size_t load() const noexcept {
+    return count.load(std::memory_order_acquire);
+  }
+};
+
+template <typename T, bool thread_safe>
+struct cow_block {
+  template <typename... Args>
+  explicit cow_block(in_place_t, Args&&... args)
+      : value(std::forward<Args>(args)...) {}
+
+  cow_counter<thread_safe> refs;
+  T value;
+};
+} // namespace detail
+
+/*******************************************************************************
+ *                           Copy-on-write optional                            *
+ *******************************************************************************/
+
+// optional<T> whose payload lives in a refcounted heap block shared between
+// copies: copying is a counter increment, whatever the size of T. Mutable
+// access (non-const `operator*`, `operator->`, `emplace`) clones the payload
+// first if it is shared, so copies still behave as independent values.
+//
+// References obtained through mutable access are only private until the
+// cow_optional is copied again; read through `std::as_const` to avoid needless
+// clones. With `thread_safe = false` the counter is a plain integer and copies
+// must not be shared between threads.
+template <typename T, bool thread_safe = true>
+class cow_optional {
+  using block = detail::cow_block<T, thread_safe>;
+
+public:
+  using value_type = T;
+
+  constexpr cow_optional() noexcept = default;
+
+  constexpr cow_optional(nullopt_t) noexcept {}
+
+  template <typename... Args>
+  explicit cow_optional(in_place_t, Args&&... args)
+      : ptr{new block(in_place, std::forward<Args>(args)...)} {}
+
+  template <typename U = T,
+            typename = std::enable_if_t<
+                std::is_constructible_v<T, U&&> &&
+                !std::is_same_v<std::remove_cvref_t<U>, cow_optional> &&
+                !std::is_same_v<std::remove_cvref_t<U>, in_place_t> &&
+                !std::is_same_v<std::remove_cvref_t<U>, nullopt_t> &&
+                !std::is_same_v<std::remove_cvref_t<U>, optional<T>>>>
+  explicit(!std::is_convertible_v<U&&, T>) cow_optional(U&& value_)
+      : ptr{new block(in_place, std::forward<U>(value_))} {}
+
+  explicit cow_optional(const optional<T>& other) {
+    if (other) {
+      ptr = new block(in_place, *other);
+    }
+  }
+
+  explicit cow_optional(optional<T>&& other) {
+    if (other) {
+      ptr = new block(in_place, std::move(*other));
+    }
+  }
+
+  cow_optional(const cow_optional& other) noexcept : ptr{other.ptr} {
+    if (ptr) {
+      ptr->refs.acquire();
+    }
+  }
+
+  cow_optional(cow_optional&& other) noexcept
+      : ptr{std::exchange(other.ptr, nullptr)} {}
+
+  cow_optional& operator=(const cow_optional& other) noexcept {
+    cow_optional(other).swap(*this);
+    return *this;
+  }
+
+  cow_optional& operator=(cow_optional&& other) noexcept {
+    cow_optional(std::move(other)).swap(*this);
+    return *this;
+  }
+
+  cow_optional& operator=(nullopt_t) noexcept {
+    reset();
+    return *this;
+  }
+
+  // Assigns in place when the payload is ours, otherwise builds a new one
+  template <typename U = T,
+            typename = std::enable_if_t<
+                std::is_constructible_v<T, U&&> &&
+                std::is_assignable_v<T&, U&&> &&
+                !std::is_same_v<std::remove_cvref_t<U>, cow_optional> &&
+                !std::is_same_v<std::remove_cvref_t<U>, nullopt_t> &&
+                !std::is_same_v<std::remove_cvref_t<U>, optional<T>>>>
+  cow_optional& operator=(U&& value_) {
+    if (unique()) {
+      ptr->value = std::forward<U>(value_);
+    } else {
+      emplace(std::forward<U>(value_));
+    }
+    return *this;
+  }
+
+  ~cow_optional() {
+    reset();
+  }
+
+  explicit operator bool() const noexcept {
+    return ptr != nullptr;
+  }
+
+  [[nodiscard]] bool has_value() const noexcept {
+    return ptr != nullptr;
+  }
+
+  T const& operator*() const noexcept {
+    assert(ptr);
+    return ptr->value;
+  }
+
+  T const* operator->() const noexcept {
+    assert(ptr);
+    return &ptr->value;
+  }
+
+  // Mutable access clones a shared payload
+  T& operator*() {
+    assert(ptr);
+    detach();
+    return ptr->value;
+  }
+
+  T* operator->() {
+    assert(ptr);
+    detach();
+    return &ptr->value;
+  }
+
+  template <typename U>
+  T value_or(U&& default_value) const& {
+    return ptr ? ptr->value : static_cast<T>(std::forward<U>(default_value));
+  }
+
+  template <typename... Args>
+  T& emplace(Args&&... args) {
+    block* fresh = new block(in_place, std::forward<Args>(args)...);
+    reset();
+    ptr = fresh;
+    return ptr->value;
+  }
+
+  void reset() noexcept {
+    if (block* old = std::exchange(ptr, nullptr)) {
+      release(old);
+    }
+  }
+
+  void swap(cow_optional& other) noexcept {
+    std::swap(ptr, other.ptr);
+  }
+
+  // Number of cow_optionals sharing the payload, 0 if disengaged
+  std::size_t use_count() const noexcept {
+    return ptr ? ptr->refs.load() : 0;
+  }
+
+  bool unique() const noexcept {
+    return use_count() == 1;
+  }
+
+  // Whether both share the same payload, in which case they compare equal
+  // without looking at T (`==` of T is assumed to be reflexive)
+  bool shares_with(const cow_optional& other) const noexcept {
+    return ptr == other.ptr;
+  }
+
+  optional<T> to_optional() const {
+    return ptr ? optional<T>(ptr->value) : optional<T>();
+  }
+
+private:
+  // Drops a reference to a block that no cow_optional points to anymore
+  static void release(block* b) noexcept {
+    if (b->refs.release()) {
+      destroy(b);
+    }
+  }
+
+  // Out of line, like libstdc++'s `_M_release_last_use`: keeps the common
+  // decrement small, and GCC no longer sees the delete next to the
+  // decrements of other copies that it cannot prove to be live
+  // (-Wuse-after-free false positives in optimized builds)
+  [[gnu::noinline]] static void destroy(block* b) noexcept {
+    delete b;
+  }
+
+  void detach() {
+    if (!unique()) {
+      block* copy = new block(in_place, std::as_const(ptr->value));
+      reset();
+      ptr = copy;
+    }
+  }
+
+  block* ptr{nullptr};
+};
+
+template <typename T, bool thread_safe>
+void swap(cow_optional<T, thread_safe>& a,
+          cow_optional<T, thread_safe>& b) noexcept {
+  a.swap(b);
+}
+
+template <typename T, bool thread_safe>
+bool operator==(cow_optional<T, thread_safe> const& a,
+                cow_optional<T, thread_safe> const& b) {
+  if (a.shares_with(b)) {
+    return true;
+  } else if (static_cast<bool>(a) != static_cast<bool>(b)) {
+    return false;
+  } else {
+    assert(a && b);
+    return *a == *b;
+  }
+}
+
+template <typename T, bool thread_safe>
+bool operator!=(cow_optional<T, thread_safe> const& a,
+                cow_optional<T, thread_safe> const& b) {
+  return !(a == b);
+}
+
+template <typename T, bool thread_safe>
+bool operator<(cow_optional<T, thread_safe> const& a,
+               cow_optional<T, thread_safe> const& b) {
+  if (!b || a.shares_with(b)) {
+    return false;
+  } else if (!a) {
+    return true;
+  } else {
+    return *a < *b;
+  }
+}
+
+template <typename T, bool thread_safe>
+bool operator<=(cow_optional<T, thread_safe> const& a,
+                cow_optional<T, thread_safe> const& b) {
+  return !(b < a);
+}
+
+template <typename T, bool thread_safe>
+bool operator>(cow_optional<T, thread_safe> const& a,
+               cow_optional<T, thread_safe> const& b) {
+  return b < a;
+}
+
+template <typename T, bool thread_safe>
+bool operator>=(cow_optional<T, thread_safe> const& a,
+                cow_optional<T, thread_safe> const& b) {
+  return !(a < b);
+}
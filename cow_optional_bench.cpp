@@ -0,0 +1,73 @@
+#include "cow_optional.h"
+#include <benchmark/benchmark.h>
+#include <map>
+#include <string>
+#include <vector>
+
+// A request carrying a large configuration through a pipeline: every stage
+// takes its own copy and only reads it. optional<config> deep-copies the
+// payload per stage, cow_optional bumps a counter.
+
+namespace {
+struct config {
+  std::map<std::string, std::string> settings;
+  std::vector<std::string> hosts;
+};
+
+config make_config() {
+  config c;
+  for (int i = 0; i < 32; ++i) {
+    c.settings["key." + std::to_string(i)] =
+        "a value that does not fit in the SSO #" + std::to_string(i);
+    c.hosts.push_back("host-" + std::to_string(i) + ".example.com");
+  }
+  return c;
+}
+
+constexpr int stages = 8;
+
+template <typename Optional>
+[[gnu::noinline]] std::size_t stage(Optional request_config) {
+  return request_config ? std::as_const(request_config)->hosts.size() : 0;
+}
+
+template <typename Optional>
+void pipeline(benchmark::State& state) {
+  Optional request_config(make_config());
+  for (auto _ : state) {
+    std::size_t total = 0;
+    for (int i = 0; i < stages; ++i) {
+      total += stage<Optional>(request_config);
+    }
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * stages);
+}
+} // namespace
+
+static void BM_pipeline_optional(benchmark::State& state) {
+  pipeline<optional<config>>(state);
+}
+BENCHMARK(BM_pipeline_optional);
+
+static void BM_pipeline_cow_optional(benchmark::State& state) {
+  pipeline<cow_optional<config>>(state);
+}
+BENCHMARK(BM_pipeline_cow_optional);
+
+static void BM_pipeline_cow_optional_single_threaded(benchmark::State& state) {
+  pipeline<cow_optional<config, false>>(state);
+}
+BENCHMARK(BM_pipeline_cow_optional_single_threaded);
+
+// The price of the first write to a shared payload
+static void BM_cow_optional_copy_and_write(benchmark::State& state) {
+  cow_optional<config> request_config(make_config());
+  for (auto _ : state) {
+    auto copy = request_config;
+    copy->hosts.push_back("extra.example.com");
+    benchmark::DoNotOptimize(copy);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_cow_optional_copy_and_write);
@@ -0,0 +1,151 @@
+#include "cow_optional.h"
+#include "test_object.h"
+#include "gtest/gtest.h"
+#include <string>
+#include <thread>
+#include <utility>
+#include <vector>
+
+TEST(cow_optional_testing, default_and_value) {
+  cow_optional<std::string> a;
+  cow_optional<std::string> b(nullopt);
+  cow_optional<std::string> c("text");
+  cow_optional<std::string> d(in_place, 3, 'x');
+  EXPECT_FALSE(a.has_value());
+  EXPECT_FALSE(static_cast<bool>(b));
+  EXPECT_EQ(0, a.use_count());
+  EXPECT_EQ("text", *c);
+  EXPECT_EQ(4, c->size());
+  EXPECT_EQ("xxx", *std::as_const(d));
+  EXPECT_EQ("none", a.value_or("none"));
+  EXPECT_EQ("text", c.value_or("none"));
+}
+
+TEST(cow_optional_testing, copy_shares_payload) {
+  test_object::no_new_instances_guard g;
+  {
+    cow_optional<test_object> a(42);
+    cow_optional<test_object> b = a;
+    cow_optional<test_object> c;
+    c = b;
+    EXPECT_EQ(3, a.use_count());
+    EXPECT_TRUE(a.shares_with(c));
+    EXPECT_EQ(&*std::as_const(a), &*std::as_const(c));
+    EXPECT_EQ(42, *std::as_const(c));
+  }
+  g.expect_no_instances();
+}
+
+TEST(cow_optional_testing, mutation_detaches) {
+  cow_optional<std::vector<int>> a(std::vector<int>{1, 2, 3});
+  auto b = a;
+  b->push_back(4);
+  EXPECT_EQ(1, a.use_count());
+  EXPECT_EQ(1, b.use_count());
+  EXPECT_EQ((std::vector<int>{1, 2, 3}), *std::as_const(a));
+  EXPECT_EQ((std::vector<int>{1, 2, 3, 4}), *std::as_const(b));
+
+  // A unique payload is mutated in place
+  auto const* before = &*std::as_const(b);
+  (*b)[0] = 10;
+  EXPECT_EQ(before, &*std::as_const(b));
+  EXPECT_EQ(1, (*std::as_const(a))[0]);
+}
+
+TEST(cow_optional_testing, const_access_does_not_detach) {
+  cow_optional<std::string> a("shared");
+  auto const b = a;
+  EXPECT_EQ(6, b->size());
+  EXPECT_EQ("shared", *b);
+  EXPECT_EQ(2, a.use_count());
+}
+
+TEST(cow_optional_testing, assignment) {
+  cow_optional<std::string> a("one");
+  auto b = a;
+  b = "two";
+  EXPECT_EQ("one", *std::as_const(a));
+  EXPECT_EQ("two", *std::as_const(b));
+  EXPECT_EQ(1, a.use_count());
+
+  b = nullopt;
+  EXPECT_FALSE(b.has_value());
+  EXPECT_EQ(1, a.use_count());
+
+  b = std::move(a);
+  EXPECT_FALSE(a.has_value());
+  EXPECT_EQ("one", *std::as_const(b));
+
+  b = b;
+  EXPECT_EQ(1, b.use_count());
+  EXPECT_EQ("one", *std::as_const(b));
+}
+
+TEST(cow_optional_testing, emplace_and_reset) {
+  test_object::no_new_instances_guard g;
+  {
+    cow_optional<test_object> a(1);
+    auto b = a;
+    b.emplace(2);
+    EXPECT_EQ(1, *std::as_const(a));
+    EXPECT_EQ(2, *std::as_const(b));
+    a.reset();
+    EXPECT_FALSE(a.has_value());
+    EXPECT_EQ(1, b.use_count());
+  }
+  g.expect_no_instances();
+}
+
+TEST(cow_optional_testing, optional_round_trip) {
+  optional<std::string> o("value");
+  cow_optional<std::string> a(o);
+  EXPECT_EQ(o, a.to_optional());
+  EXPECT_FALSE(cow_optional<std::string>(optional<std::string>()).has_value());
+  EXPECT_FALSE(cow_optional<std::string>().to_optional().has_value());
+}
+
+TEST(cow_optional_testing, comparison) {
+  cow_optional<int> empty, one(1), two(2);
+  auto one_copy = one;
+  EXPECT_EQ(one, one_copy);
+  EXPECT_EQ(one, cow_optional<int>(1));
+  EXPECT_NE(one, two);
+  EXPECT_NE(empty, one);
+  EXPECT_LT(empty, one);
+  EXPECT_LT(one, two);
+  EXPECT_LE(one, one_copy);
+  EXPECT_GT(two, one);
+  EXPECT_GE(two, empty);
+  EXPECT_FALSE(one < one_copy);
+}
+
+TEST(cow_optional_testing, single_threaded_counts) {
+  cow_optional<std::string, false> a("local");
+  auto b = a;
+  auto c = b;
+  EXPECT_EQ(3, a.use_count());
+  *c = "changed";
+  EXPECT_EQ(2, a.use_count());
+  EXPECT_EQ("local", *std::as_const(b));
+  EXPECT_EQ("changed", *std::as_const(c));
+}
+
+TEST(cow_optional_testing, copies_across_threads) {
+  cow_optional<std::string> shared("payload that does not fit in the SSO");
+  std::vector<std::thread> threads;
+  for (int t = 0; t < 4; ++t) {
+    threads.emplace_back([copy = shared, t]() mutable {
+      for (int i = 0; i < 1000; ++i) {
+        cow_optional<std::string> local = copy;
+        EXPECT_EQ('p', std::as_const(local)->front());
+      }
+      *copy = std::to_string(t);
+      EXPECT_EQ(std::to_string(t), *std::as_const(copy));
+    });
+  }
+  for (auto& thread : threads) {
+    thread.join();
+  }
+  EXPECT_EQ(1, shared.use_count());
+  EXPECT_EQ("payload that does not fit in the SSO", *std::as_const(shared));
+}
@@ -0,0 +1,392 @@
+#pragma once
+
+#include "expected_bases.h"
+#include "member_switches.h"
+
+#include <exception>
+#include <functional>
+
+template <typename E>
+class bad_expected_access : public std::exception {
+public:
+  explicit bad_expected_access(E error_) : err{std::move(error_)} {}
+
+  const char* what() const noexcept override {
+    return "bad expected access";
+  }
+
+  E const& error() const& noexcept {
+    return err;
+  }
+
+  E& error() & noexcept {
+    return err;
+  }
+
+private:
+  E err;
+};
+
+/*******************************************************************************
+ *                                  Expected                                   *
+ *******************************************************************************/
+
+template <typename T, typename E>
+class expected
+    : public detail::move_assign_base<detail::expected_storage<T, E>>,
+      private detail::enable_copy_construction<
+          std::is_copy_constructible_v<T> && std::is_copy_constructible_v<E>>,
+      private detail::enable_copy_assignment<
+          std::is_copy_assignable_v<T> && std::is_copy_constructible_v<T> &&
+          std::is_copy_assignable_v<E> && std::is_copy_constructible_v<E>>,
+      private detail::enable_move_construction<
+          std::is_move_constructible_v<T> && std::is_move_constructible_v<E>>,
+      private detail::enable_move_assignment<
+          std::is_move_assignable_v<T> && std::is_move_constructible_v<T> &&
+          std::is_move_assignable_v<E> && std::is_move_constructible_v<E>> {
+  static_assert(!std::is_reference_v<T> && !std::is_void_v<T>,
+                "expected of references or void is not supported");
+  static_assert(!std::is_reference_v<E> && !std::is_void_v<E>,
+                "error type must be an object type");
+
+  using base = detail::move_assign_base<detail::expected_storage<T, E>>;
+
+public:
+  using value_type = T;
+  using error_type = E;
+  using unexpected_type = unexpected<E>;
+
+  template <typename U>
+  using rebind = expected<U, E>;
+
+  using base::operator=;
+
+  constexpr expected() requires std::is_default_constructible_v<T>
+      : base{in_place} {}
+
+  constexpr expected(const T& value_) : base{in_place, value_} {}
+
+  constexpr expected(T&& value_) : base{in_place, std::move(value_)} {}
+
+  template <typename G>
+  constexpr expected(const unexpected<G>& error_)
+      : base{unexpect, error_.error()} {}
+
+  template <typename G>
+  constexpr expected(unexpected<G>&& error_)
+      : base{unexpect, std::move(error_).error()} {}
+
+  template <typename... Args>
+  constexpr expected(in_place_t, Args&&... args)
+      : base{in_place, std::forward<Args>(args)...} {}
+
+  template <typename... Args>
+  constexpr expected(unexpect_t, Args&&... args)
+      : base{unexpect, std::forward<Args>(args)...} {}
+
+  constexpr expected(expected const&) = default;
+  constexpr expected(expected&&) = default;
+
+  expected& operator=(expected const&) = default;
+  expected& operator=(expected&&) = default;
+
+  template <typename G>
+  expected& operator=(const unexpected<G>& error_) {
+    assign_error(error_.error());
+    return *this;
+  }
+
+  template <typename G>
+  expected& operator=(unexpected<G>&& error_) {
+    assign_error(std::move(error_).error());
+    return *this;
+  }
+
+  constexpr explicit operator bool() const noexcept {
+    return this->has_val;
+  }
+
+  [[nodiscard]] constexpr bool has_value() const noexcept {
+    return this->has_val;
+  }
+
+  constexpr T& operator*() & noexcept {
+    return this->val;
+  }
+
+  constexpr T const& operator*() const& noexcept {
+    return this->val;
+  }
+
+  constexpr T&& operator*() && noexcept {
+    return std::move(this->val);
+  }
+
+  constexpr T* operator->() noexcept {
+    return &this->val;
+  }
+
+  constexpr T const* operator->() const noexcept {
+    return &this->val;
+  }
+
+  constexpr T& value() & {
+    check_value();
+    return this->val;
+  }
+
+  constexpr T const& value() const& {
+    check_value();
+    return this->val;
+  }
+
+  constexpr T&& value() && {
+    check_value();
+    return std::move(this->val);
+  }
+
+  constexpr E& error() & noexcept {
+    return this->err;
+  }
+
+  constexpr E const& error() const& noexcept {
+    return this->err;
+  }
+
+  constexpr E&& error() && noexcept {
+    return std::move(this->err);
+  }
+
+  template <typename U>
+  constexpr T value_or(U&& default_value) const& {
+    return has_value() ? this->val
+                       : static_cast<T>(std::forward<U>(default_value));
+  }
+
+  template <typename U>
+  constexpr T value_or(U&& default_value) && {
+    return has_value() ? std::move(this->val)
+                       : static_cast<T>(std::forward<U>(default_value));
+  }
+
+  template <typename G>
+  constexpr E error_or(G&& default_error) const& {
+    return has_value() ? static_cast<E>(std::forward<G>(default_error))
+                       : this->err;
+  }
+
+  template <typename... Args>
+  T& emplace(Args&&... args) {
+    if (this->has_val) {
+      // args may refer to the held value, read them before it is replaced
+      T tmp(std::forward<Args>(args)...);
+      this->val = std::move(tmp);
+    } else {
+      detail::reinit_expected(this->val, this->err,
+                              std::forward<Args>(args)...);
+      this->has_val = true;
+    }
+    return this->val;
+  }
+
+  // Monadic operations
+
+  // F: T -> expected<U, E>
+  template <typename F>
+  constexpr auto and_then(F&& f) & {
+    return and_then_impl(*this, std::forward<F>(f));
+  }
+
+  template <typename F>
+  constexpr auto and_then(F&& f) const& {
+    return and_then_impl(*this, std::forward<F>(f));
+  }
+
+  template <typename F>
+  constexpr auto and_then(F&& f) && {
+    return and_then_impl(std::move(*this), std::forward<F>(f));
+  }
+
+  // F: E -> expected<T, G>
+  template <typename F>
+  constexpr auto or_else(F&& f) & {
+    return or_else_impl(*this, std::forward<F>(f));
+  }
+
+  template <typename F>
+  constexpr auto or_else(F&& f) const& {
+    return or_else_impl(*this, std::forward<F>(f));
+  }
+
+  template <typename F>
+  constexpr auto or_else(F&& f) && {
+    return or_else_impl(std::move(*this), std::forward<F>(f));
+  }
+
+  // F: T -> U
+  template <typename F>
+  constexpr auto transform(F&& f) & {
+    return transform_impl(*this, std::forward<F>(f));
+  }
+
+  template <typename F>
+  constexpr auto transform(F&& f) const& {
+    return transform_impl(*this, std::forward<F>(f));
+  }
+
+  template <typename F>
+  constexpr auto transform(F&& f) && {
+    return transform_impl(std::move(*this), std::forward<F>(f));
+  }
+
+  // F: E -> G
+  template <typename F>
+  constexpr auto transform_error(F&& f) & {
+    return transform_error_impl(*this, std::forward<F>(f));
+  }
+
+  template <typename F>
+  constexpr auto transform_error(F&& f) const& {
+    return transform_error_impl(*this, std::forward<F>(f));
+  }
+
+  template <typename F>
+  constexpr auto transform_error(F&& f) && {
+    return transform_error_impl(std::move(*this), std::forward<F>(f));
+  }
+
+  void swap(expected& other) noexcept(
+      std::is_nothrow_move_constructible_v<T>&&
+          std::is_nothrow_swappable_v<T>&&
+              std::is_nothrow_move_constructible_v<E>&&
+                  std::is_nothrow_swappable_v<E>) {
+    using std::swap;
+    if (has_value() && other.has_value()) {
+      swap(this->val, other.val);
+    } else if (!has_value() && !other.has_value()) {
+      swap(this->err, other.err);
+    } else if (has_value()) {
+      // Park whichever payload moves without throwing, so a throw on the
+      // other one can be rolled back from the temporary
+      if constexpr (std::is_nothrow_move_constructible_v<E>) {
+        E tmp(std::move(other.err));
+        std::destroy_at(&other.err);
+        try {
+          std::construct_at(&other.val, std::move(this->val));
+        } catch (...) {
+          std::construct_at(&other.err, std::move(tmp));
+          throw;
+        }
+        std::destroy_at(&this->val);
+        std::construct_at(&this->err, std::move(tmp));
+      } else {
+        T tmp(std::move(this->val));
+        std::destroy_at(&this->val);
+        try {
+          std::construct_at(&this->err, std::move(other.err));
+        } catch (...) {
+          std::construct_at(&this->val, std::move(tmp));
+          throw;
+        }
+        std::destroy_at(&other.err);
+        std::construct_at(&other.val, std::move(tmp));
+      }
+      this->has_val = false;
+      other.has_val = true;
+    } else {
+      other.swap(*this);
+    }
+  }
+
+private:
+  constexpr void check_value() const {
+    if (!this->has_val) {
+      throw bad_expected_access<E>(this->err);
+    }
+  }
+
+  template <typename G>
+  void assign_error(G&& error_) {
+    if (this->has_val) {
+      detail::reinit_expected(this->err, this->val, std::forward<G>(error_));
+      this->has_val = false;
+    } else {
+      this->err = std::forward<G>(error_);
+    }
+  }
+
+  template <typename Self, typename F>
+  static constexpr auto and_then_impl(Self&& self, F&& f) {
+    using result = std::remove_cvref_t<
+        std::invoke_result_t<F, decltype(*std::declval<Self>())>>;
+    static_assert(std::is_same_v<typename result::error_type, E>,
+                  "and_then must keep the error type");
+    if (self.has_value()) {
+      return std::invoke(std::forward<F>(f), *std::forward<Self>(self));
+    }
+    return result(unexpect, std::forward<Self>(self).error());
+  }
+
+  template <typename Self, typename F>
+  static constexpr auto or_else_impl(Self&& self, F&& f) {
+    using result = std::remove_cvref_t<
+        std::invoke_result_t<F, decltype(std::declval<Self>().error())>>;
+    static_assert(std::is_same_v<typename result::value_type, T>,
+                  "or_else must keep the value type");
+    if (self.has_value()) {
+      return result(in_place, *std::forward<Self>(self));
+    }
+    return std::invoke(std::forward<F>(f), std::forward<Self>(self).error());
+  }
+
+  template <typename Self, typename F>
+  static constexpr auto transform_impl(Self&& self, F&& f) {
+    using value = std::remove_cv_t<
+        std::invoke_result_t<F, decltype(*std::declval<Self>())>>;
+    static_assert(!std::is_void_v<value>, "transform must return a value");
+    using result = expected<value, E>;
+    if (self.has_value()) {
+      return result(in_place,
+                    std::invoke(std::forward<F>(f), *std::forward<Self>(self)));
+    }
+    return result(unexpect, std::forward<Self>(self).error());
+  }
+
+  template <typename Self, typename F>
+  static constexpr auto transform_error_impl(Self&& self, F&& f) {
+    using error = std::remove_cv_t<
+        std::invoke_result_t<F, decltype(std::declval<Self>().error())>>;
+    using result = expected<T, error>;
+    if (self.has_value()) {
+      return result(in_place, *std::forward<Self>(self));
+    }
+    return result(unexpect, std::invoke(std::forward<F>(f),
+                                        std::forward<Self>(self).error()));
+  }
+};
+
+template <typename T, typename E>
+constexpr bool operator==(expected<T, E> const& a, expected<T, E> const& b) {
+  if (a.has_value() != b.has_value()) {
+    return false;
+  } else if (a.has_value()) {
+    return *a == *b;
+  } else {
+    return a.error() == b.error();
+  }
+}
+
+template <typename T, typename E>
+constexpr bool operator!=(expected<T, E> const& a, expected<T, E> const& b) {
+  return !(a == b);
+}
+
+template <typename T, typename E, typename G>
+constexpr bool operator==(expected<T, E> const& a, unexpected<G> const& b) {
+  return !a.has_value() && a.error() == b.error();
+}
+
+template <typename T, typename E>
+void swap(expected<T, E>& a, expected<T, E>& b) noexcept(noexcept(a.swap(b))) {
+  a.swap(b);
+}
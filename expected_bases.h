@@ -0,0 +1,209 @@
+#pragma once
+
+#include "optional_bases.h"
+
+#include <cassert>
+#include <memory>
+#include <type_traits>
+#include <utility>
+
+struct unexpect_t {};
+inline constexpr unexpect_t unexpect;
+
+template <typename E>
+class unexpected {
+public:
+  constexpr explicit unexpected(const E& error_) : err{error_} {}
+  constexpr explicit unexpected(E&& error_) : err{std::move(error_)} {}
+
+  template <typename... Args>
+  constexpr explicit unexpected(in_place_t, Args&&... args)
+      : err(std::forward<Args>(args)...) {}
+
+  constexpr E& error() & noexcept {
+    return err;
+  }
+
+  constexpr E const& error() const& noexcept {
+    return err;
+  }
+
+  constexpr E&& error() && noexcept {
+    return std::move(err);
+  }
+
+  friend constexpr bool operator==(unexpected const& a, unexpected const& b) {
+    return a.err == b.err;
+  }
+
+private:
+  E err;
+};
+
+template <typename E>
+unexpected(E) -> unexpected<E>;
+
+namespace detail {
+// Replaces the active member `old_value` by a `New` built from `args`, keeping
+// the old member alive if the construction throws
+template <typename New, typename Old, typename... Args>
+constexpr void reinit_expected(New& new_value, Old& old_value,
+                               Args&&... args) {
+  if constexpr (std::is_nothrow_constructible_v<New, Args...>) {
+    std::destroy_at(&old_value);
+    std::construct_at(&new_value, std::forward<Args>(args)...);
+  } else if constexpr (std::is_nothrow_move_constructible_v<New>) {
+    New tmp(std::forward<Args>(args)...);
+    std::destroy_at(&old_value);
+    std::construct_at(&new_value, std::move(tmp));
+  } else {
+    Old tmp(std::move(old_value));
+    std::destroy_at(&old_value);
+    try {
+      std::construct_at(&new_value, std::forward<Args>(args)...);
+    } catch (...) {
+      std::construct_at(&old_value, std::move(tmp));
+      throw;
+    }
+  }
+}
+
+/*******************************************************************************
+ *                                   Storage                                   *
+ *******************************************************************************/
+
+// The value or the error and the flag telling which one is alive
+template <typename T, typename E,
+          bool trivial = std::is_trivially_destructible_v<T> &&
+                         std::is_trivially_destructible_v<E>>
+struct expected_union {
+  union {
+    char dummy;
+    T val;
+    E err;
+  };
+  bool has_val;
+
+  // Neither alternative is alive yet
+  constexpr expected_union() noexcept : dummy{}, has_val{false} {}
+
+  template <typename... Args>
+  constexpr expected_union(in_place_t, Args&&... args)
+      : val(std::forward<Args>(args)...), has_val{true} {}
+
+  template <typename... Args>
+  constexpr expected_union(unexpect_t, Args&&... args)
+      : err(std::forward<Args>(args)...), has_val{false} {}
+
+  // The alive member is destroyed by `expected_storage`
+  constexpr ~expected_union() {}
+};
+
+template <typename T, typename E>
+struct expected_union<T, E, true> {
+  union {
+    char dummy;
+    T val;
+    E err;
+  };
+  bool has_val;
+
+  constexpr expected_union() noexcept : dummy{}, has_val{false} {}
+
+  template <typename... Args>
+  constexpr expected_union(in_place_t, Args&&... args)
+      : val(std::forward<Args>(args)...), has_val{true} {}
+
+  template <typename... Args>
+  constexpr expected_union(unexpect_t, Args&&... args)
+      : err(std::forward<Args>(args)...), has_val{false} {}
+
+  // No user defined destructor => trivial
+};
+
+// Lifetime operations of an expected for the triviality chain of
+// `optional_bases.h`
+template <typename T, typename E>
+struct expected_storage_ops : expected_union<T, E> {
+  using base = expected_union<T, E>;
+  using payloads = payload_list<T, E>;
+
+  template <typename... Args>
+  constexpr expected_storage_ops(in_place_t, Args&&... args)
+      : base{in_place, std::forward<Args>(args)...} {}
+
+  template <typename... Args>
+  constexpr expected_storage_ops(unexpect_t, Args&&... args)
+      : base{unexpect, std::forward<Args>(args)...} {}
+
+  // Not delegating: if the copy throws, no alternative is alive and the
+  // destructor must not run
+  template <typename Other>
+  constexpr expected_storage_ops(from_storage_t, Other&& other) : base{} {
+    construct_from(std::forward<Other>(other));
+  }
+
+  constexpr void destroy() noexcept {
+    if (this->has_val) {
+      std::destroy_at(&this->val);
+    } else {
+      std::destroy_at(&this->err);
+    }
+  }
+
+  // Builds the alternative of `other` in a storage where none is alive
+  template <typename Other>
+  constexpr void construct_from(Other&& other) {
+    if (other.has_val) {
+      std::construct_at(&this->val, std::forward<Other>(other).val);
+    } else {
+      std::construct_at(&this->err, std::forward<Other>(other).err);
+    }
+    this->has_val = other.has_val;
+  }
+
+  template <typename Other>
+  constexpr void assign_from(Other&& other) {
+    if (this->has_val && other.has_val) {
+      this->val = std::forward<Other>(other).val;
+    } else if (this->has_val) {
+      reinit_expected(this->err, this->val, std::forward<Other>(other).err);
+    } else if (other.has_val) {
+      reinit_expected(this->val, this->err, std::forward<Other>(other).val);
+    } else {
+      this->err = std::forward<Other>(other).err;
+    }
+    this->has_val = other.has_val;
+  }
+};
+
+template <typename T, typename E,
+          bool trivial = std::is_trivially_destructible_v<T> &&
+                         std::is_trivially_destructible_v<E>>
+struct expected_storage : expected_storage_ops<T, E> {
+  using base = expected_storage_ops<T, E>;
+  using base::base;
+
+  constexpr expected_storage(const expected_storage&) = default;
+  constexpr expected_storage(expected_storage&&) = default;
+  constexpr expected_storage& operator=(expected_storage&&) = default;
+  constexpr expected_storage& operator=(const expected_storage&) = default;
+
+  constexpr ~expected_storage() {
+    this->destroy();
+  }
+};
+
+template <typename T, typename E>
+struct expected_storage<T, E, true> : expected_storage_ops<T, E> {
+  using base = expected_storage_ops<T, E>;
+  using base::base;
+
+  constexpr expected_storage(const expected_storage&) = default;
+  constexpr expected_storage(expected_storage&&) = default;
+  constexpr expected_storage& operator=(expected_storage&&) = default;
+  constexpr expected_storage& operator=(const expected_storage&) = default;
+
+  // No user defined destructor => trivial
+};
+} // namespace detail
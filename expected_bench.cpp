@@ -0,0 +1,81 @@
+#include "expected.h"
+#include <benchmark/benchmark.h>
+#include <stdexcept>
+#include <string_view>
+#include <vector>
+
+// Error handling cost of `expected` against exceptions. The argument is the
+// error rate in percent of the parsed inputs.
+
+namespace {
+enum class parse_error { empty, bad_digit };
+
+struct parse_exception : std::exception {};
+
+std::vector<std::string_view> make_inputs(int error_percent) {
+  std::vector<std::string_view> inputs;
+  for (int i = 0; i < 1000; ++i) {
+    inputs.push_back(i % 100 < error_percent ? "12x4" : "12345");
+  }
+  return inputs;
+}
+
+[[gnu::noinline]] expected<int, parse_error>
+parse_expected(std::string_view s) {
+  if (s.empty()) {
+    return unexpected(parse_error::empty);
+  }
+  int result = 0;
+  for (char c : s) {
+    if (c < '0' || c > '9') {
+      return unexpected(parse_error::bad_digit);
+    }
+    result = result * 10 + (c - '0');
+  }
+  return result;
+}
+
+[[gnu::noinline]] int parse_throwing(std::string_view s) {
+  if (s.empty()) {
+    throw parse_exception();
+  }
+  int result = 0;
+  for (char c : s) {
+    if (c < '0' || c > '9') {
+      throw parse_exception();
+    }
+    result = result * 10 + (c - '0');
+  }
+  return result;
+}
+} // namespace
+
+static void BM_expected_error_path(benchmark::State& state) {
+  auto inputs = make_inputs(static_cast<int>(state.range(0)));
+  for (auto _ : state) {
+    long long sum = 0;
+    for (auto s : inputs) {
+      sum += parse_expected(s).value_or(-1);
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * inputs.size());
+}
+BENCHMARK(BM_expected_error_path)->Arg(0)->Arg(1)->Arg(10)->Arg(50);
+
+static void BM_exception_error_path(benchmark::State& state) {
+  auto inputs = make_inputs(static_cast<int>(state.range(0)));
+  for (auto _ : state) {
+    long long sum = 0;
+    for (auto s : inputs) {
+      try {
+        sum += parse_throwing(s);
+      } catch (parse_exception const&) {
+        sum += -1;
+      }
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * inputs.size());
+}
+BENCHMARK(BM_exception_error_path)->Arg(0)->Arg(1)->Arg(10)->Arg(50);
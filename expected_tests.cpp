@@ -0,0 +1,228 @@
+#include "expected.h"
+#include "test_classes.h"
+#include "test_object.h"
+#include "gtest/gtest.h"
+#include <memory>
+#include <stdexcept>
+#include <string>
+
+namespace {
+enum class parse_error { empty, bad_digit };
+
+expected<int, parse_error> parse(std::string_view s) {
+  if (s.empty()) {
+    return unexpected(parse_error::empty);
+  }
+  int result = 0;
+  for (char c : s) {
+    if (c < '0' || c > '9') {
+      return unexpected(parse_error::bad_digit);
+    }
+    result = result * 10 + (c - '0');
+  }
+  return result;
+}
+} // namespace
+
+TEST(expected_testing, default_ctor) {
+  expected<int, parse_error> a;
+  EXPECT_TRUE(a.has_value());
+  EXPECT_EQ(0, *a);
+}
+
+TEST(expected_testing, value_and_error_ctor) {
+  test_object::no_new_instances_guard g;
+  expected<test_object, std::string> a(42);
+  expected<test_object, std::string> b(unexpect, "failure");
+  EXPECT_TRUE(static_cast<bool>(a));
+  EXPECT_EQ(42, *a);
+  EXPECT_FALSE(static_cast<bool>(b));
+  EXPECT_EQ("failure", b.error());
+}
+
+TEST(expected_testing, value_throws_on_error) {
+  expected<int, parse_error> a = parse("x");
+  EXPECT_THROW(a.value(), bad_expected_access<parse_error>);
+  EXPECT_EQ(parse_error::bad_digit, a.error());
+  EXPECT_EQ(7, a.value_or(7));
+  EXPECT_EQ(parse_error::empty, parse("1").error_or(parse_error::empty));
+}
+
+TEST(expected_testing, copy_and_move) {
+  test_object::no_new_instances_guard g;
+  expected<test_object, test_object> a(42);
+  expected<test_object, test_object> b(unexpect, 13);
+  expected<test_object, test_object> c = a;
+  expected<test_object, test_object> d = std::move(b);
+  EXPECT_EQ(42, *c);
+  EXPECT_EQ(13, d.error());
+}
+
+TEST(expected_testing, assignment_switches_alternative) {
+  test_object::no_new_instances_guard g;
+  expected<test_object, test_object> a(1), b(unexpect, 2);
+  a = b;
+  EXPECT_FALSE(a.has_value());
+  EXPECT_EQ(2, a.error());
+  a = expected<test_object, test_object>(3);
+  EXPECT_TRUE(a.has_value());
+  EXPECT_EQ(3, *a);
+  a = unexpected(test_object(4));
+  EXPECT_EQ(4, a.error());
+}
+
+TEST(expected_testing, emplace) {
+  test_object::no_new_instances_guard g;
+  expected<test_object, std::string> a(unexpect, "error");
+  a.emplace(5);
+  EXPECT_EQ(5, *a);
+  a.emplace(6);
+  EXPECT_EQ(6, *a);
+}
+
+namespace {
+// Its copy constructor destroys the member it built and throws
+struct throwing_copy_t {
+  explicit throwing_copy_t(int x) : object{x} {}
+  throwing_copy_t(const throwing_copy_t& other) : object{other.object} {
+    throw std::runtime_error("copy");
+  }
+
+  test_object object;
+};
+} // namespace
+
+// A copy that throws leaves no alternative alive, nothing is destroyed twice
+TEST(expected_testing, copy_ctor_throws) {
+  test_object::no_new_instances_guard g;
+  expected<throwing_copy_t, int> a(in_place, 1);
+  using copied_value_t = expected<throwing_copy_t, int>;
+  EXPECT_THROW(copied_value_t{a}, std::runtime_error);
+  expected<int, throwing_copy_t> b(unexpect, 2);
+  using copied_error_t = expected<int, throwing_copy_t>;
+  EXPECT_THROW(copied_error_t{b}, std::runtime_error);
+}
+
+// Payloads are direct-initialized, like std::expected: no initializer_list
+// constructor, no narrowing
+TEST(expected_testing, direct_init) {
+  expected<std::string, int> a(in_place, 3, 'x');
+  EXPECT_EQ("xxx", *a);
+  expected<int, std::string> b(unexpect, 2, 'e');
+  EXPECT_EQ("ee", b.error());
+  a.emplace(4, 'y');
+  EXPECT_EQ("yyyy", *a);
+  b.emplace(7L);
+  EXPECT_EQ(7, *b);
+  EXPECT_EQ("zz", unexpected<std::string>(in_place, 2, 'z').error());
+}
+
+// Arguments referring to the held value are read before it is replaced
+TEST(expected_testing, emplace_self) {
+  test_object::no_new_instances_guard g;
+  expected<test_object, int> a(3);
+  a.emplace(*a);
+  EXPECT_EQ(3, *a);
+  expected<std::string, int> b("text");
+  b.emplace(std::move(*b));
+  EXPECT_EQ("text", *b);
+}
+
+TEST(expected_testing, swap) {
+  test_object::no_new_instances_guard g;
+  expected<test_object, std::string> a(1), b(unexpect, "error");
+  swap(a, b);
+  EXPECT_EQ("error", a.error());
+  EXPECT_EQ(1, *b);
+}
+
+namespace {
+struct throwing_move_t {
+  explicit throwing_move_t(int x) : value{x} {}
+  throwing_move_t(throwing_move_t&&) { throw std::runtime_error("move"); }
+  throwing_move_t& operator=(throwing_move_t&&) = default;
+
+  int value;
+};
+} // namespace
+
+// A value move that throws leaves both sides as they were
+TEST(expected_testing, swap_throws) {
+  expected<throwing_move_t, std::string> a(in_place, 1), b(unexpect, "error");
+  EXPECT_THROW(a.swap(b), std::runtime_error);
+  EXPECT_EQ(1, a->value);
+  EXPECT_EQ("error", b.error());
+  EXPECT_THROW(b.swap(a), std::runtime_error);
+  EXPECT_EQ(1, a->value);
+  EXPECT_EQ("error", b.error());
+}
+
+TEST(expected_testing, and_then) {
+  auto twice = [](int x) -> expected<int, parse_error> { return 2 * x; };
+  EXPECT_EQ(84, *parse("42").and_then(twice));
+  EXPECT_EQ(parse_error::empty, parse("").and_then(twice).error());
+}
+
+TEST(expected_testing, or_else) {
+  auto recover = [](parse_error) -> expected<int, parse_error> { return -1; };
+  EXPECT_EQ(-1, *parse("").or_else(recover));
+  EXPECT_EQ(5, *parse("5").or_else(recover));
+}
+
+TEST(expected_testing, transform) {
+  auto r = parse("12").transform([](int x) { return std::to_string(x + 1); });
+  static_assert(
+      std::is_same_v<decltype(r), expected<std::string, parse_error>>);
+  EXPECT_EQ("13", *r);
+  auto e = parse("").transform_error([](parse_error) { return 404; });
+  static_assert(std::is_same_v<decltype(e), expected<int, int>>);
+  EXPECT_EQ(404, e.error());
+}
+
+TEST(expected_testing, move_only) {
+  expected<std::unique_ptr<int>, std::string> a(std::make_unique<int>(5));
+  auto b = std::move(a).transform([](std::unique_ptr<int> p) { return *p; });
+  EXPECT_EQ(5, *b);
+}
+
+TEST(expected_testing, comparison) {
+  expected<int, parse_error> a(1), b(1), c(unexpect, parse_error::empty);
+  EXPECT_TRUE(a == b);
+  EXPECT_FALSE(a == c);
+  EXPECT_TRUE(c == unexpected(parse_error::empty));
+}
+
+TEST(traits, expected) {
+  using expected1 = expected<int, parse_error>;
+  using expected2 = expected<std::string, int>;
+  using expected3 = expected<int, std::string>;
+  using expected4 = expected<no_copy_t, int>;
+  using expected5 = expected<std::unique_ptr<int>, int>;
+  ASSERT_TRUE(std::is_trivially_copyable_v<expected1>);
+  ASSERT_TRUE(std::is_trivially_destructible_v<expected1>);
+  ASSERT_FALSE(std::is_trivially_copyable_v<expected2>);
+  ASSERT_FALSE(std::is_trivially_copy_constructible_v<expected3>);
+  ASSERT_FALSE(std::is_copy_constructible_v<expected4>);
+  ASSERT_FALSE(std::is_copy_constructible_v<expected5>);
+  ASSERT_TRUE(std::is_move_constructible_v<expected5>);
+  using expected6 = expected<no_default_t, int>;
+  ASSERT_FALSE(std::is_default_constructible_v<expected6>);
+  ASSERT_FALSE((std::is_constructible_v<expected1, detail::from_storage_t,
+                                        const expected1&>));
+  ASSERT_EQ(sizeof(std::uint64_t), sizeof(expected<int, parse_error>));
+}
+
+static_assert([] {
+  expected<int, parse_error> a(42);
+  return a.has_value() && *a == 42;
+}());
+
+static_assert([] {
+  expected<int, parse_error> a(unexpect, parse_error::empty), b = a;
+  return b.error() == parse_error::empty;
+}());
+
+static_assert([] {
+  expected<int, int> a(1);
+  return *a.transform([](int x) { return x + 1; }) == 2;
+}());
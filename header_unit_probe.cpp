@@ -0,0 +1,11 @@
+// Imports optional.h as a header unit instead of including it, see the
+// header_unit_probe target. Exits with 0 if the imported declarations work.
+
+import "optional.h";
+
+int main() {
+  optional<long> a = 42, b;
+  b = a;
+  optional<int> empty = nullopt;
+  return a == b && *b == 42 && !empty ? 0 : 1;
+}
@@ -0,0 +1,12 @@
+// Imports the named module from optional.cppm instead of including
+// optional.h, see the module_probe target. Exits with 0 if the exported
+// declarations work.
+
+import optional;
+
+int main() {
+  optional<long> a = 42, b;
+  b = a;
+  optional<int> empty = nullopt;
+  return a == b && *b == 42 && !empty ? 0 : 1;
+}
@@ -0,0 +1,39 @@
+// `import optional;` as a replacement for including optional.h.
+//
+// The headers are parsed once, when this interface unit is compiled, instead
+// of in every translation unit. They stay the source of truth: code that does
+// not use modules includes them as before. CMake builds it as the
+// `optional_module` target, checked by module_probe.cpp, when it is 3.28 or
+// newer and the compiler supports named modules (GCC 14, Clang 16, MSVC 19.34).
+//
+// Toolchains that cannot build named modules yet can still skip the re-parse
+// by importing the header as a header unit, see header_unit_probe.cpp:
+//
+//   import "optional.h";  // g++ -fmodules-ts, clang++ -fmodule-header
+//
+// ci-extra/header-unit-build-bench.sh compares the build time of the textual
+// include and the header unit.
+module;
+
+#include "optional.h"
+
+export module optional;
+
+export using ::in_place;
+export using ::in_place_t;
+export using ::nullopt;
+export using ::nullopt_t;
+export using ::optional;
+
+export using ::is_trivially_relocatable;
+export using ::is_trivially_relocatable_v;
+
+export using ::as_optional;
+export using ::as_std;
+
+export using ::operator==;
+export using ::operator!=;
+export using ::operator<;
+export using ::operator<=;
+export using ::operator>;
+export using ::operator>=;
@@ -3,29 +3,116 @@
 #include "member_switches.h"
 #include "optional_bases.h"
 
+#include <memory>
+#include <optional>
+
+template <typename T>
+class optional;
+
+namespace detail {
+// Whether T could also be built from / assigned from optional<U> itself, in
+// which case converting from optional<U> would be ambiguous
+template <typename T, typename U>
+inline constexpr bool converts_from_optional =
+    std::is_constructible_v<T, optional<U>&> ||
+    std::is_constructible_v<T, const optional<U>&> ||
+    std::is_constructible_v<T, optional<U>&&> ||
+    std::is_constructible_v<T, const optional<U>&&> ||
+    std::is_convertible_v<optional<U>&, T> ||
+    std::is_convertible_v<const optional<U>&, T> ||
+    std::is_convertible_v<optional<U>&&, T> ||
+    std::is_convertible_v<const optional<U>&&, T>;
+
+template <typename T>
+inline constexpr bool is_std_optional = false;
+
+template <typename T>
+inline constexpr bool is_std_optional<std::optional<T>> = true;
+
+template <typename T, typename U>
+inline constexpr bool assigns_from_optional =
+    std::is_assignable_v<T&, optional<U>&> ||
+    std::is_assignable_v<T&, const optional<U>&> ||
+    std::is_assignable_v<T&, optional<U>&&> ||
+    std::is_assignable_v<T&, const optional<U>&&>;
+
+// Whether an argument list is allocator-extended, i.e. leads with
+// std::allocator_arg
+template <typename... Args>
+inline constexpr bool leads_with_allocator_arg = false;
+
+template <typename First, typename... Rest>
+inline constexpr bool leads_with_allocator_arg<First, Rest...> =
+    std::is_same_v<std::remove_cvref_t<First>, std::allocator_arg_t>;
+} // namespace detail
+
 /*******************************************************************************
  *                                  Optional                                   *
  *******************************************************************************/
 
 template <typename T>
 class optional
-    : public detail::move_assign_base<T>,
+    : public detail::move_assign_base<detail::storage_base<T>>,
       private detail::enable_copy_construction<std::is_copy_constructible_v<T>>,
       private detail::enable_copy_assignment<std::is_copy_assignable_v<T> &&
                                              std::is_copy_constructible_v<T>>,
       private detail::enable_move_construction<std::is_move_constructible_v<T>>,
       private detail::enable_move_assignment<std::is_move_assignable_v<T> &&
                                              std::is_move_constructible_v<T>> {
-  using base = detail::move_assign_base<T>;
+  using base = detail::move_assign_base<detail::storage_base<T>>;
 
 public:
   using base::base;
-  using base::operator=;
   constexpr optional() noexcept = default;
 
-  constexpr optional(const T& value_) : base{in_place, value_} {}
+  // Builds the payload directly from `value_`, without a temporary T
+  template <typename U = T,
+            typename = std::enable_if_t<
+                std::is_constructible_v<T, U&&> &&
+                !std::is_same_v<std::remove_cvref_t<U>, in_place_t> &&
+                !std::is_same_v<std::remove_cvref_t<U>, optional> &&
+                !detail::is_std_optional<std::remove_cvref_t<U>>>>
+  constexpr explicit(!std::is_convertible_v<U&&, T>) optional(U&& value_)
+      : base{in_place, std::forward<U>(value_)} {}
 
-  constexpr optional(T&& value_) : base{in_place, std::move(value_)} {}
+  template <typename U,
+            typename = std::enable_if_t<
+                std::is_constructible_v<T, const U&> &&
+                !detail::converts_from_optional<T, U>>>
+  constexpr explicit(!std::is_convertible_v<const U&, T>)
+      optional(const optional<U>& other)
+      : base{} {
+    if (other) {
+      construct(*other);
+    }
+  }
+
+  template <typename U,
+            typename = std::enable_if_t<std::is_constructible_v<T, U&&> &&
+                                        !detail::converts_from_optional<T, U>>>
+  constexpr explicit(!std::is_convertible_v<U&&, T>)
+      optional(optional<U>&& other)
+      : base{} {
+    if (other) {
+      construct(std::move(*other));
+    }
+  }
+
+  // Interop with std::optional. Conversions copy or move the payload; to pass
+  // an optional across an API boundary without that, see `as_std`.
+  constexpr optional(const std::optional<T>& other)
+      requires std::is_copy_constructible_v<T> : base{} {
+    if (other) {
+      construct(*other);
+    }
+  }
+
+  constexpr optional(std::optional<T>&& other)
+      requires std::is_move_constructible_v<T> : base{} {
+    if (other) {
+      construct(std::move(*other));
+    }
+  }
 
   template <typename... Args>
   constexpr optional(in_place_t, Args&&... args)
@@ -33,6 +120,51 @@ public:
 
   constexpr optional(nullopt_t) noexcept : base{} {}
 
+  // Uses-allocator construction: the payload receives `alloc` the way
+  // `std::make_obj_using_allocator` would pass it, so an optional living in an
+  // allocator-aware container (e.g. a pmr arena) keeps its payload there too.
+  template <typename Alloc>
+  optional(std::allocator_arg_t, const Alloc&) noexcept : base{} {}
+
+  template <typename Alloc, typename... Args>
+  optional(std::allocator_arg_t, const Alloc& alloc, in_place_t,
+           Args&&... args)
+      : base{} {
+    construct_using_allocator(alloc, std::forward<Args>(args)...);
+  }
+
+  template <typename Alloc>
+  optional(std::allocator_arg_t, const Alloc& alloc, const optional& other)
+      : base{} {
+    if (other) {
+      construct_using_allocator(alloc, *other);
+    }
+  }
+
+  template <typename Alloc>
+  optional(std::allocator_arg_t, const Alloc& alloc, optional&& other)
+      : base{} {
+    if (other) {
+      construct_using_allocator(alloc, std::move(*other));
+    }
+  }
+
+  template <typename Alloc, typename U,
+            typename = std::enable_if_t<
+                std::is_constructible_v<T, U&&> &&
+                !std::is_same_v<std::remove_cvref_t<U>, in_place_t> &&
+                !std::is_same_v<std::remove_cvref_t<U>, nullopt_t> &&
+                !std::is_same_v<std::remove_cvref_t<U>, optional> &&
+                !detail::is_std_optional<std::remove_cvref_t<U>>>>
+  explicit(!std::is_convertible_v<U&&, T>)
+      optional(std::allocator_arg_t, const Alloc& alloc, U&& value_)
+      : base{} {
+    construct_using_allocator(alloc, std::forward<U>(value_));
+  }
+
+  template <typename Alloc>
+  optional(std::allocator_arg_t, const Alloc&, nullopt_t) noexcept : base{} {}
+
   constexpr optional(optional const&) = default;
   constexpr optional(optional&&) = default;
 
@@ -44,35 +176,134 @@ public:
     return *this;
   }
 
+  // Scalars keep going through `optional(U&&)` so that `o = {}` resets
+  template <typename U = T,
+            typename = std::enable_if_t<
+                !std::is_same_v<std::remove_cvref_t<U>, optional> &&
+                !detail::is_std_optional<std::remove_cvref_t<U>> &&
+                std::is_constructible_v<T, U> && std::is_assignable_v<T&, U> &&
+                (!std::is_scalar_v<T> || !std::is_same_v<std::decay_t<U>, T>)>>
+  constexpr optional& operator=(U&& value_) {
+    if (this->payload.active) {
+      this->payload.value = std::forward<U>(value_);
+    } else {
+      construct(std::forward<U>(value_));
+    }
+    return *this;
+  }
+
+  template <typename U,
+            typename = std::enable_if_t<
+                std::is_constructible_v<T, const U&> &&
+                std::is_assignable_v<T&, const U&> &&
+                !detail::converts_from_optional<T, U> &&
+                !detail::assigns_from_optional<T, U>>>
+  constexpr optional& operator=(const optional<U>& other) {
+    if (!other) {
+      this->reset();
+    } else if (this->payload.active) {
+      this->payload.value = *other;
+    } else {
+      construct(*other);
+    }
+    return *this;
+  }
+
+  template <typename U,
+            typename = std::enable_if_t<
+                std::is_constructible_v<T, U> && std::is_assignable_v<T&, U> &&
+                !detail::converts_from_optional<T, U> &&
+                !detail::assigns_from_optional<T, U>>>
+  constexpr optional& operator=(optional<U>&& other) {
+    if (!other) {
+      this->reset();
+    } else if (this->payload.active) {
+      this->payload.value = std::move(*other);
+    } else {
+      construct(std::move(*other));
+    }
+    return *this;
+  }
+
   constexpr explicit operator bool() const noexcept {
-    return this->active;
+    return this->payload.active;
+  }
+
+  constexpr operator std::optional<T>() const&
+      requires std::is_copy_constructible_v<T> {
+    if (!this->payload.active) {
+      return std::nullopt;
+    }
+    return std::optional<T>(std::in_place, this->payload.value);
+  }
+
+  constexpr operator std::optional<T>() &&
+      requires std::is_move_constructible_v<T> {
+    if (!this->payload.active) {
+      return std::nullopt;
+    }
+    return std::optional<T>(std::in_place, std::move(this->payload.value));
   }
 
   constexpr T& operator*() noexcept {
-    return this->value;
+    return this->payload.value;
   }
 
   constexpr T const& operator*() const noexcept {
-    return this->value;
+    return this->payload.value;
   }
 
   constexpr T* operator->() noexcept {
-    return &this->value;
+    return &this->payload.value;
   }
 
   constexpr T const* operator->() const noexcept {
-    return &this->value;
+    return &this->payload.value;
   }
 
   template <typename... Args>
-  void emplace(Args&&... args) {
+  constexpr void emplace(Args&&... args)
+      requires(!detail::leads_with_allocator_arg<Args...>) {
+    this->reset();
+    construct(std::forward<Args>(args)...);
+  }
+
+  template <typename Alloc, typename... Args>
+  void emplace(std::allocator_arg_t, const Alloc& alloc, Args&&... args) {
+    this->reset();
+    construct_using_allocator(alloc, std::forward<Args>(args)...);
+  }
+
+  // Moves the payload out and leaves the optional disengaged
+  T take() {
+    assert(has_value());
+    T result(std::move(this->payload.value));
     this->reset();
-    new (&(this->value)) T{std::forward<Args>(args)...};
-    this->active = true;
+    return result;
+  }
+
+  // Stores a new payload and returns the previous contents. The new payload is
+  // built first, so value_ may refer to the current one and a throwing
+  // constructor leaves the optional unchanged. Both payloads are then
+  // relocated, for trivially relocatable T that is a plain byte copy without a
+  // move and a destructor call.
+  template <typename U = T>
+  optional exchange(U&& value_) {
+    optional next(in_place, std::forward<U>(value_));
+    optional old;
+    if (this->payload.active) {
+      detail::relocate(&old.payload.value, &this->payload.value);
+      old.payload.active = true;
+      this->payload.active = false;
+    }
+    detail::relocate(&this->payload.value, &next.payload.value);
+    next.payload.active = false;
+    this->payload.active = true;
+    return old;
   }
 
-  [[nodiscard]] bool has_value() const noexcept {
-    return this->active;
+  [[nodiscard]] constexpr bool has_value() const noexcept {
+    return this->payload.active;
   }
 
   void swap(optional& other) noexcept(std::is_nothrow_move_constructible_v<T>&&
@@ -82,15 +313,75 @@ public:
       using std::swap;
       swap(**this, *other);
     } else if (has_value() && !other.has_value()) {
-      other = std::move(*this);
-      this->reset();
+      detail::relocate(&other.payload.value, &this->payload.value);
+      other.payload.active = true;
+      this->payload.active = false;
     } else if (!has_value() && other.has_value()) {
-      *this = std::move(other);
-      other.reset();
+      other.swap(*this);
     }
   }
+
+private:
+  template <typename... Args>
+  constexpr void construct(Args&&... args) {
+    std::construct_at(&(this->payload.value), std::forward<Args>(args)...);
+    this->payload.active = true;
+  }
+
+  template <typename Alloc, typename... Args>
+  void construct_using_allocator(const Alloc& alloc, Args&&... args) {
+    std::uninitialized_construct_using_allocator(
+        &(this->payload.value), alloc, std::forward<Args>(args)...);
+    this->payload.active = true;
+  }
+};
+
+// Lets allocator-aware containers pass their allocator down to the payload
+template <typename T, typename Alloc>
+struct std::uses_allocator<optional<T>, Alloc> : std::uses_allocator<T, Alloc> {
 };
 
+/*******************************************************************************
+ *                             std::optional views                             *
+ *******************************************************************************/
+
+namespace detail {
+// The flag offset of std::optional cannot be probed in a constant expression
+// (bit_cast rejects types with a union member). libstdc++ and libc++ both store
+// the payload union first and the flag right after it, like `storage_base`;
+// the tests check it on the bytes of live objects.
+#if defined(__GLIBCXX__) || defined(_LIBCPP_VERSION)
+inline constexpr bool std_flag_follows_payload = true;
+#else
+inline constexpr bool std_flag_follows_payload = false;
+#endif
+
+// With the same member order, equal size and alignment put the flag at the
+// same offset
+template <typename T>
+inline constexpr bool std_layout_compatible =
+    std_flag_follows_payload &&
+    sizeof(optional<T>) == sizeof(std::optional<T>) &&
+    alignof(optional<T>) == alignof(std::optional<T>);
+} // namespace detail
+
+// Borrowed views between this optional and std::optional of the same T, for
+// APIs that take the other type by const reference: no payload is copied.
+// Only available where the two layouts are verified to match.
+template <typename T>
+const std::optional<T>& as_std(const optional<T>& o) noexcept {
+  static_assert(detail::std_layout_compatible<T>,
+                "optional<T> and std::optional<T> layouts differ");
+  return *std::launder(reinterpret_cast<const std::optional<T>*>(&o));
+}
+
+template <typename T>
+const optional<T>& as_optional(const std::optional<T>& o) noexcept {
+  static_assert(detail::std_layout_compatible<T>,
+                "optional<T> and std::optional<T> layouts differ");
+  return *std::launder(reinterpret_cast<const optional<T>*>(&o));
+}
+
 template <typename T>
 constexpr bool operator==(optional<T> const& a, optional<T> const& b) {
   if (static_cast<bool>(a) != static_cast<bool>(b)) {
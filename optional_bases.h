@@ -1,70 +1,185 @@
 #pragma once
 
 #include <cassert>
+#include <cstring>
+#include <memory>
+#include <new>
 #include <type_traits>
 #include <utility>
 
-struct nullopt_t {};
-inline constexpr nullopt_t nullopt;
+// Not default constructible, so that `o = {}` is not ambiguous between
+// resetting through nullopt_t and assigning an empty optional
+struct nullopt_t {
+  struct tag {};
+  constexpr explicit nullopt_t(tag) noexcept {}
+};
+inline constexpr nullopt_t nullopt{nullopt_t::tag{}};
 struct in_place_t {};
 inline constexpr in_place_t in_place;
 
+// Moving a T into fresh storage and destroying the source has the same effect
+// as copying its bytes. Holds for trivially copyable types; specialize it for
+// types like owning pointers that relocate by bytes but are not trivially
+// copyable.
+template <typename T>
+struct is_trivially_relocatable : std::is_trivially_copyable<T> {};
+
+template <typename T>
+inline constexpr bool is_trivially_relocatable_v =
+    is_trivially_relocatable<T>::value;
+
 namespace detail {
+// Moves *src into the raw storage at dst and ends the lifetime of *src
+template <typename T>
+void relocate(T* dst, T* src) noexcept(
+    is_trivially_relocatable_v<T> || std::is_nothrow_move_constructible_v<T>) {
+  if constexpr (is_trivially_relocatable_v<T>) {
+    std::memcpy(static_cast<void*>(dst), static_cast<const void*>(src),
+                sizeof(T));
+  } else {
+    new (dst) T(std::move(*src));
+    src->~T();
+  }
+}
+
 /*******************************************************************************
  *                       Storage & destructor triviality                       *
  *******************************************************************************/
 
+// Payload types of a storage, the special members of the chain below are
+// trivial when they are trivial for all of them
+template <typename... Ts>
+struct payload_list {};
+
+template <template <typename> typename Trait, typename List>
+inline constexpr bool all_payloads = false;
+
+template <template <typename> typename Trait, typename... Ts>
+inline constexpr bool all_payloads<Trait, payload_list<Ts...>> =
+    (Trait<Ts>::value && ...);
+
+// Payload first, flag second: the same layout as std::optional in libstdc++
+// and libc++, see `as_std`. The pair is a member of `storage_base` rather than
+// part of it, GCC does not keep a base subobject with this layout in registers.
 template <typename T, bool trivial = std::is_trivially_destructible_v<T>>
-struct storage_base {
-  bool active{false};
+struct payload_storage {
   union {
-    char dummy{};
+    char dummy;
     T value;
   };
+  bool active;
 
-  void reset() noexcept {
-    if (active) {
-      value.~T();
-      active = false;
-    }
-  }
-
-  constexpr storage_base() noexcept : active{false}, dummy{} {}
-  constexpr storage_base(const storage_base&) = default;
-  constexpr storage_base(storage_base&&) = default;
-  constexpr storage_base& operator=(storage_base&&) = default;
-  constexpr storage_base& operator=(const storage_base&) = default;
+  constexpr payload_storage() noexcept : dummy{}, active{false} {}
 
   template <typename... Args>
-  constexpr storage_base(in_place_t, Args&&... args)
-      : active{true}, value{std::forward<Args>(args)...} {}
+  constexpr payload_storage(in_place_t, Args&&... args)
+      : value(std::forward<Args>(args)...), active{true} {}
 
-  ~storage_base() {
-    reset();
-  }
+  // The payload is destroyed by `storage_base`
+  constexpr ~payload_storage() {}
 };
 
 template <typename T>
-struct storage_base<T, true> {
-  bool active{false};
+struct payload_storage<T, true> {
   union {
-    char dummy{};
+    char dummy;
     T value;
   };
+  bool active;
+
+  constexpr payload_storage() noexcept : dummy{}, active{false} {}
+
+  template <typename... Args>
+  constexpr payload_storage(in_place_t, Args&&... args)
+      : value(std::forward<Args>(args)...), active{true} {}
+
+  // No user defined destructor => trivial
+};
+
+// Selects the constructor that copies or moves another storage of the same
+// type, which the non-trivial copy and move constructors below call
+struct from_storage_t {};
+inline constexpr from_storage_t from_storage;
+
+// Storage of a single optional. Every storage used with the triviality chain
+// below provides `payloads`, a `(from_storage_t, other)` constructor and an
+// `assign_from(other)` member taking another storage of the same type by
+// const& or &&. If the constructor throws, it must leave nothing to destroy:
+// the destructor of the storage does not run.
+template <typename T>
+struct optional_storage {
+  using payloads = payload_list<T>;
+
+  payload_storage<T> payload;
+
+  constexpr optional_storage() noexcept : payload{} {}
+
+  template <typename... Args>
+  constexpr optional_storage(in_place_t, Args&&... args)
+      : payload{in_place, std::forward<Args>(args)...} {}
 
-  void reset() noexcept {
-    active = false;
+  // The payload is engaged only once it is built
+  template <typename Other>
+  constexpr optional_storage(from_storage_t, Other&& other) : payload{} {
+    construct_from(std::forward<Other>(other));
   }
 
-  constexpr storage_base() noexcept : active{false}, dummy{} {}
+  constexpr void reset() noexcept {
+    if constexpr (std::is_trivially_destructible_v<T>) {
+      payload.active = false;
+    } else if (payload.active) {
+      std::destroy_at(&payload.value);
+      payload.active = false;
+    }
+  }
+
+  template <typename Other>
+  constexpr void construct_from(Other&& other) {
+    if (other.payload.active) {
+      std::construct_at(&payload.value,
+                        std::forward<Other>(other).payload.value);
+      payload.active = true;
+    }
+  }
+
+  template <typename Other>
+  constexpr void assign_from(Other&& other) {
+    if (!other.payload.active) {
+      reset();
+    } else if (payload.active) {
+      payload.value = std::forward<Other>(other).payload.value;
+    } else {
+      construct_from(std::forward<Other>(other));
+    }
+  }
+};
+
+template <typename T, bool trivial = std::is_trivially_destructible_v<T>>
+struct storage_base : optional_storage<T> {
+  using base = optional_storage<T>;
+  using base::base;
+
+  constexpr storage_base() noexcept = default;
   constexpr storage_base(const storage_base&) = default;
   constexpr storage_base(storage_base&&) = default;
   constexpr storage_base& operator=(storage_base&&) = default;
   constexpr storage_base& operator=(const storage_base&) = default;
 
-  template <typename... Args>
-  constexpr storage_base(in_place_t, Args&&... args)
-      : active{true}, value{std::forward<Args>(args)...} {}
+  constexpr ~storage_base() {
+    this->reset();
+  }
+};
+
+template <typename T>
+struct storage_base<T, true> : optional_storage<T> {
+  using base = optional_storage<T>;
+  using base::base;
+
+  constexpr storage_base() noexcept = default;
+  constexpr storage_base(const storage_base&) = default;
+  constexpr storage_base(storage_base&&) = default;
+  constexpr storage_base& operator=(storage_base&&) = default;
+  constexpr storage_base& operator=(const storage_base&) = default;
 
   // No user defined destructor => trivial
 };
@@ -73,9 +188,11 @@ struct storage_base<T, true> {
  *                          Copy construct triviality                          *
  *******************************************************************************/
 
-template <typename T, bool trivial = std::is_trivially_copy_constructible_v<T>>
-struct copy_ctor_base : storage_base<T> {
-  using base = storage_base<T>;
+template <typename Storage,
+          bool trivial = all_payloads<std::is_trivially_copy_constructible,
+                                      typename Storage::payloads>>
+struct copy_ctor_base : Storage {
+  using base = Storage;
   using base::base;
 
   constexpr copy_ctor_base() = default;
@@ -83,17 +200,13 @@ struct copy_ctor_base : storage_base<T> {
   constexpr copy_ctor_base(copy_ctor_base&& other) = default;
   constexpr copy_ctor_base& operator=(copy_ctor_base&& other) = default;
 
-  constexpr copy_ctor_base(const copy_ctor_base& other) : base{} {
-    this->active = other.active;
-    if (other.active) {
-      new (&(this->value)) T{other.value};
-    }
-  }
+  constexpr copy_ctor_base(const copy_ctor_base& other)
+      : base{from_storage, static_cast<const Storage&>(other)} {}
 };
 
-template <typename T>
-struct copy_ctor_base<T, true> : storage_base<T> {
-  using base = storage_base<T>;
+template <typename Storage>
+struct copy_ctor_base<Storage, true> : Storage {
+  using base = Storage;
   using base::base;
 
   constexpr copy_ctor_base() = default;
@@ -107,10 +220,13 @@ struct copy_ctor_base<T, true> : storage_base<T> {
  *                         Copy assignment triviality                          *
  *******************************************************************************/
 
-template <typename T, bool trivial = std::is_trivially_copy_assignable_v<T>&&
-                          std::is_trivially_copy_constructible_v<T>>
-struct copy_assign_base : copy_ctor_base<T> {
-  using base = copy_ctor_base<T>;
+template <typename Storage,
+          bool trivial = all_payloads<std::is_trivially_copy_assignable,
+                                      typename Storage::payloads> &&
+                         all_payloads<std::is_trivially_copy_constructible,
+                                      typename Storage::payloads>>
+struct copy_assign_base : copy_ctor_base<Storage> {
+  using base = copy_ctor_base<Storage>;
   using base::base;
 
   constexpr copy_assign_base() = default;
@@ -119,27 +235,16 @@ struct copy_assign_base : copy_ctor_base<T> {
   constexpr copy_assign_base& operator=(copy_assign_base&& other) = default;
 
   constexpr copy_assign_base& operator=(copy_assign_base const& other) {
-    if (this == &other) {
-      return *this;
-    }
-    if (!other.active) {
-      this->reset();
-      return *this;
-    }
-    assert(other.active);
-    if (this->active) {
-      this->value = other.value;
-    } else {
-      new (&(this->value)) T{other.value};
+    if (this != &other) {
+      this->assign_from(static_cast<const Storage&>(other));
     }
-    this->active = true;
     return *this;
   }
 };
 
-template <typename T>
-struct copy_assign_base<T, true> : copy_ctor_base<T> {
-  using base = copy_ctor_base<T>;
+template <typename Storage>
+struct copy_assign_base<Storage, true> : copy_ctor_base<Storage> {
+  using base = copy_ctor_base<Storage>;
   using base::base;
 
   constexpr copy_assign_base() = default;
@@ -153,9 +258,11 @@ struct copy_assign_base<T, true> : copy_ctor_base<T> {
  *                        Move construction triviality                         *
  *******************************************************************************/
 
-template <typename T, bool trivial = std::is_trivially_move_constructible_v<T>>
-struct move_ctor_base : copy_assign_base<T> {
-  using base = copy_assign_base<T>;
+template <typename Storage,
+          bool trivial = all_payloads<std::is_trivially_move_constructible,
+                                      typename Storage::payloads>>
+struct move_ctor_base : copy_assign_base<Storage> {
+  using base = copy_assign_base<Storage>;
   using base::base;
   using base::operator=;
 
@@ -164,17 +271,13 @@ struct move_ctor_base : copy_assign_base<T> {
   constexpr move_ctor_base& operator=(move_ctor_base const&) = default;
   constexpr move_ctor_base& operator=(move_ctor_base&&) = default;
 
-  constexpr move_ctor_base(move_ctor_base&& other) : base{} {
-    this->active = other.active;
-    if (other.active) {
-      new (&(this->value)) T{std::move(other.value)};
-    }
-  }
+  constexpr move_ctor_base(move_ctor_base&& other)
+      : base{from_storage, static_cast<Storage&&>(other)} {}
 };
 
-template <typename T>
-struct move_ctor_base<T, true> : copy_assign_base<T> {
-  using base = copy_assign_base<T>;
+template <typename Storage>
+struct move_ctor_base<Storage, true> : copy_assign_base<Storage> {
+  using base = copy_assign_base<Storage>;
   using base::base;
   using base::operator=;
 
@@ -189,10 +292,13 @@ struct move_ctor_base<T, true> : copy_assign_base<T> {
  *                         Move assignment triviality                          *
  *******************************************************************************/
 
-template <typename T, bool trivial = std::is_trivially_move_assignable_v<T>&&
-                          std::is_trivially_move_constructible_v<T>>
-struct move_assign_base : move_ctor_base<T> {
-  using base = move_ctor_base<T>;
+template <typename Storage,
+          bool trivial = all_payloads<std::is_trivially_move_assignable,
+                                      typename Storage::payloads> &&
+                         all_payloads<std::is_trivially_move_constructible,
+                                      typename Storage::payloads>>
+struct move_assign_base : move_ctor_base<Storage> {
+  using base = move_ctor_base<Storage>;
   using base::base;
   using base::operator=;
 
@@ -202,27 +308,16 @@ struct move_assign_base : move_ctor_base<T> {
   constexpr move_assign_base(move_assign_base&& other) = default;
 
   constexpr move_assign_base& operator=(move_assign_base&& other) {
-    if (this == &other) {
-      return *this;
+    if (this != &other) {
+      this->assign_from(static_cast<Storage&&>(other));
     }
-    if (!other.active) {
-      this->reset();
-      return *this;
-    }
-    assert(other.active);
-    if (this->active) {
-      this->value = std::move(other.value);
-    } else {
-      new (&(this->value)) T{std::move(other.value)};
-    }
-    this->active = true;
     return *this;
   }
 };
 
-template <typename T>
-struct move_assign_base<T, true> : move_ctor_base<T> {
-  using base = move_ctor_base<T>;
+template <typename Storage>
+struct move_assign_base<Storage, true> : move_ctor_base<Storage> {
+  using base = move_ctor_base<Storage>;
   using base::base;
   using base::operator=;
 
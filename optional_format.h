@@ -0,0 +1,109 @@
+#pragma once
+
+#include "optional.h"
+
+#include <charconv>
+#include <cstring>
+#include <string_view>
+#include <system_error>
+#include <type_traits>
+#include <version>
+
+#if __has_include(<format>) && defined(__cpp_lib_format)
+#include <algorithm>
+#include <format>
+#endif
+
+/*******************************************************************************
+ *                                  to_chars                                   *
+ *******************************************************************************/
+
+// Writes an arithmetic optional into [first, last) like std::to_chars: no
+// allocation, no locale, no terminating zero. A disengaged optional is written
+// as `null_text`. The remaining arguments go to std::to_chars (a base for
+// integers, a std::chars_format and a precision for floating point). On
+// overflow returns {last, std::errc::value_too_large}.
+template <typename T, typename... Spec>
+  requires std::is_arithmetic_v<T> && (!std::is_same_v<T, bool>)
+std::to_chars_result to_chars(char* first, char* last, const optional<T>& value,
+                              std::string_view null_text, Spec... spec) {
+  if (value) {
+    return std::to_chars(first, last, *value, spec...);
+  }
+  if (static_cast<std::size_t>(last - first) < null_text.size()) {
+    return {last, std::errc::value_too_large};
+  }
+  if (!null_text.empty()) {
+    std::memcpy(first, null_text.data(), null_text.size());
+  }
+  return {first + null_text.size(), std::errc{}};
+}
+
+template <typename T>
+  requires std::is_arithmetic_v<T> && (!std::is_same_v<T, bool>)
+std::to_chars_result to_chars(char* first, char* last,
+                              const optional<T>& value) {
+  return to_chars(first, last, value, "null");
+}
+
+/*******************************************************************************
+ *                               std::formatter                                *
+ *******************************************************************************/
+
+#if __has_include(<format>) && defined(__cpp_lib_format)
+namespace detail {
+template <typename CharT>
+inline constexpr CharT default_null_text[] = {'n', 'u', 'l', 'l'};
+} // namespace detail
+
+// Formats the payload with the formatter of T and the same spec, and a
+// disengaged optional as "null". The null text can be set in brackets at the
+// start of the spec:
+//
+//   std::format("{}", o)           // 42        or null
+//   std::format("{:[n/a]>6}", o)   // "    42"  or n/a
+//   std::format("{:[]08.3f}", d)   // 0003.142  or an empty string
+//
+// A '[' followed by an alignment ('<', '^' or '>') is a fill character, as in
+// "{:[^10}", so a null text cannot start with one of those. The null text
+// cannot contain ']' and is written as is, the width does not apply to it.
+template <typename T, typename CharT>
+struct std::formatter<optional<T>, CharT> {
+  constexpr auto parse(std::basic_format_parse_context<CharT>& ctx) {
+    auto it = ctx.begin();
+    if (opens_null_text(it, ctx.end())) {
+      auto close = std::find(it + 1, ctx.end(), CharT(']'));
+      if (close == ctx.end()) {
+        throw std::format_error("missing ']' after the null text");
+      }
+      null_text = {it + 1, close};
+      ctx.advance_to(close + 1);
+    }
+    return value_formatter.parse(ctx);
+  }
+
+  template <typename FormatContext>
+  auto format(const optional<T>& value, FormatContext& ctx) const {
+    if (value) {
+      return value_formatter.format(*value, ctx);
+    }
+    return std::copy(null_text.begin(), null_text.end(), ctx.out());
+  }
+
+private:
+  // A '[' that is not followed by an alignment
+  template <typename It>
+  static constexpr bool opens_null_text(It first, It last) {
+    if (first == last || *first != CharT('[')) {
+      return false;
+    }
+    ++first;
+    return first == last || (*first != CharT('<') && *first != CharT('^') &&
+                             *first != CharT('>'));
+  }
+
+  std::formatter<T, CharT> value_formatter;
+  std::basic_string_view<CharT> null_text{::detail::default_null_text<CharT>,
+                                          4};
+};
+#endif
@@ -0,0 +1,85 @@
+#include "optional_format.h"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <random>
+#include <sstream>
+#include <vector>
+
+// Logging 64k nullable fields (10% null) into a line buffer: to_chars into a
+// preallocated buffer against the `if (o) os << *o; else os << "null";`
+// iostream idiom, with the stream reused between iterations.
+
+namespace {
+constexpr std::size_t rows = 1 << 16;
+
+template <typename T>
+std::vector<optional<T>> make_rows() {
+  std::mt19937_64 rng(5);
+  std::vector<optional<T>> result(rows);
+  for (auto& row : result) {
+    if (rng() % 10 != 0) {
+      if constexpr (std::is_floating_point_v<T>) {
+        row = static_cast<T>(rng() % 1'000'000) / 1000;
+      } else {
+        row = static_cast<T>(rng() % 1'000'000'000);
+      }
+    }
+  }
+  return result;
+}
+
+template <typename T>
+void log_to_chars(benchmark::State& state) {
+  auto values = make_rows<T>();
+  std::vector<char> line(rows * 32);
+  for (auto _ : state) {
+    char* out = line.data();
+    char* end = line.data() + line.size();
+    for (auto const& value : values) {
+      out = to_chars(out, end, value).ptr;
+      *out++ = ' ';
+    }
+    benchmark::DoNotOptimize(out);
+  }
+  state.SetItemsProcessed(state.iterations() * rows);
+}
+
+template <typename T>
+void log_ostream(benchmark::State& state) {
+  auto values = make_rows<T>();
+  std::ostringstream os;
+  for (auto _ : state) {
+    os.str({});
+    for (auto const& value : values) {
+      if (value) {
+        os << *value;
+      } else {
+        os << "null";
+      }
+      os << ' ';
+    }
+    benchmark::DoNotOptimize(os);
+  }
+  state.SetItemsProcessed(state.iterations() * rows);
+}
+} // namespace
+
+static void BM_log_int64_to_chars(benchmark::State& state) {
+  log_to_chars<std::int64_t>(state);
+}
+BENCHMARK(BM_log_int64_to_chars);
+
+static void BM_log_int64_ostream(benchmark::State& state) {
+  log_ostream<std::int64_t>(state);
+}
+BENCHMARK(BM_log_int64_ostream);
+
+static void BM_log_double_to_chars(benchmark::State& state) {
+  log_to_chars<double>(state);
+}
+BENCHMARK(BM_log_double_to_chars);
+
+static void BM_log_double_ostream(benchmark::State& state) {
+  log_ostream<double>(state);
+}
+BENCHMARK(BM_log_double_ostream);
@@ -0,0 +1,94 @@
+#include "optional_format.h"
+#include "gtest/gtest.h"
+#include <array>
+#include <charconv>
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <string_view>
+
+namespace {
+template <typename T, typename... Spec>
+std::string write(const optional<T>& value, Spec... spec) {
+  std::array<char, 64> buffer;
+  auto [end, ec] =
+      to_chars(buffer.data(), buffer.data() + buffer.size(), value, spec...);
+  EXPECT_EQ(std::errc{}, ec);
+  return std::string(buffer.data(), end);
+}
+} // namespace
+
+TEST(optional_format_testing, to_chars_integers) {
+  EXPECT_EQ("42", write(optional<int>(42)));
+  EXPECT_EQ("-7", write(optional<long long>(-7)));
+  EXPECT_EQ("18446744073709551615",
+            write(optional<std::uint64_t>(
+                std::numeric_limits<std::uint64_t>::max())));
+  EXPECT_EQ("ff", write(optional<int>(255), "null", 16));
+  EXPECT_EQ("null", write(optional<int>()));
+}
+
+TEST(optional_format_testing, to_chars_floating_point) {
+  EXPECT_EQ("0.1", write(optional<double>(0.1)));
+  EXPECT_EQ("-2.5", write(optional<float>(-2.5f)));
+  EXPECT_EQ("3.14", write(optional<double>(3.14159), "null",
+                          std::chars_format::fixed, 2));
+  EXPECT_EQ("1e+06", write(optional<double>(1e6), "null",
+                           std::chars_format::scientific));
+  EXPECT_EQ("NaN", write(optional<double>(), "NaN",
+                         std::chars_format::fixed, 2));
+}
+
+TEST(optional_format_testing, to_chars_null_text) {
+  EXPECT_EQ("n/a", write(optional<int>(), "n/a"));
+  EXPECT_EQ("", write(optional<int>(), ""));
+  EXPECT_EQ("5", write(optional<int>(5), "n/a"));
+}
+
+TEST(optional_format_testing, to_chars_overflow) {
+  char buffer[3];
+  auto result = to_chars(buffer, buffer + 3, optional<int>(12345));
+  EXPECT_EQ(std::errc::value_too_large, result.ec);
+  result = to_chars(buffer, buffer + 3, optional<int>());
+  EXPECT_EQ(std::errc::value_too_large, result.ec);
+  EXPECT_EQ(buffer + 3, result.ptr);
+  result = to_chars(buffer, buffer + 3, optional<int>(), "n/a");
+  EXPECT_EQ(std::errc{}, result.ec);
+  EXPECT_EQ("n/a", std::string_view(buffer, 3));
+}
+
+#if __has_include(<format>) && defined(__cpp_lib_format)
+TEST(optional_format_testing, formatter) {
+  EXPECT_EQ("42", std::format("{}", optional<int>(42)));
+  EXPECT_EQ("null", std::format("{}", optional<int>()));
+  EXPECT_EQ("    42", std::format("{:>6}", optional<int>(42)));
+  EXPECT_EQ("3.14", std::format("{:.2f}", optional<double>(3.14159)));
+  EXPECT_EQ("text", std::format("{}", optional<std::string>("text")));
+  EXPECT_EQ(L"null", std::format(L"{}", optional<int>()));
+}
+
+TEST(optional_format_testing, formatter_null_text) {
+  EXPECT_EQ("n/a", std::format("{:[n/a].2f}", optional<double>()));
+  EXPECT_EQ("    42", std::format("{:[n/a]>6}", optional<int>(42)));
+  EXPECT_EQ("0003.142", std::format("{:[]08.3f}", optional<double>(3.14159)));
+  EXPECT_EQ("", std::format("{:[]08.3f}", optional<double>()));
+  EXPECT_EQ("  42", std::format("{:[-]>{}}", optional<int>(42), 4));
+  EXPECT_EQ("-", std::format("{:[-]>{}}", optional<int>(), 4));
+  EXPECT_EQ("a=1 b=?", std::format("a={:[?]} b={:[?]}", optional<int>(1),
+                                   optional<int>()));
+}
+
+// '[' followed by an alignment is a fill character, not a null text
+TEST(optional_format_testing, formatter_bracket_fill) {
+  EXPECT_EQ("[[[[42[[[[", std::format("{:[^10}", optional<int>(42)));
+  EXPECT_EQ("42[[", std::format("{:[<4}", optional<int>(42)));
+  EXPECT_EQ("[[42", std::format("{:[>4}", optional<int>(42)));
+  EXPECT_EQ("null", std::format("{:[^10}", optional<int>()));
+}
+
+TEST(optional_format_testing, formatter_unclosed_null_text) {
+  optional<int> value;
+  EXPECT_THROW((void)std::vformat("{:[n/a}", std::make_format_args(value)),
+               std::format_error);
+}
+#endif
@@ -0,0 +1,153 @@
+#pragma once
+
+#include "optional.h"
+
+#include <cstddef>
+#include <cstring>
+#include <memory>
+#include <new>
+#include <type_traits>
+
+// Counterparts of the <memory> algorithms for contiguous ranges of optional<T>.
+// Unqualified calls on optional<T>* ranges pick the overloads below over the
+// std:: templates, which ADL also finds when T comes from namespace std: both
+// are exact matches and these are more specialized.
+//
+// When optional<T> is trivially copyable the ranges are copied as bytes, and a
+// fill with nullopt is a memset. Otherwise the engaged flag of each element
+// is tested once: disengaged elements only get a flag written, and only
+// engaged ones are copied or destroyed.
+//
+// The uninitialized_* algorithms give the strong guarantee: if copying a
+// payload throws, the elements built so far are destroyed and the exception
+// is rethrown, so the destination holds no live objects. `assign` works on
+// live objects and, like std::copy, leaves the elements before the failing
+// one assigned.
+
+namespace detail {
+template <typename T>
+inline constexpr bool bitwise_optional =
+    std::is_trivially_copyable_v<optional<T>>;
+
+// Disengaged optionals have nothing to destroy
+template <typename T>
+void destroy_engaged(optional<T>* first, optional<T>* last) noexcept {
+  if constexpr (!std::is_trivially_destructible_v<optional<T>>) {
+    for (; first != last; ++first) {
+      if (first->has_value()) {
+        std::destroy_at(first);
+      }
+    }
+  }
+}
+} // namespace detail
+
+/*******************************************************************************
+ *                          Uninitialized algorithms                           *
+ *******************************************************************************/
+
+template <typename T>
+optional<T>* uninitialized_copy(const optional<T>* first,
+                                const optional<T>* last, optional<T>* d_first) {
+  std::size_t n = static_cast<std::size_t>(last - first);
+  if constexpr (detail::bitwise_optional<T>) {
+    if (n != 0) {
+      std::memcpy(d_first, first, n * sizeof(optional<T>));
+    }
+    return d_first + n;
+  } else {
+    optional<T>* out = d_first;
+    try {
+      for (; first != last; ++first, ++out) {
+        if (first->has_value()) {
+          ::new (out) optional<T>(in_place, **first);
+        } else {
+          ::new (out) optional<T>();
+        }
+      }
+    } catch (...) {
+      detail::destroy_engaged(d_first, out);
+      throw;
+    }
+    return out;
+  }
+}
+
+// A non-const source would need a qualification conversion for the overload
+// above and lose to the exact match of std::uninitialized_copy
+template <typename T>
+optional<T>* uninitialized_copy(optional<T>* first, optional<T>* last,
+                                optional<T>* d_first) {
+  return ::uninitialized_copy(static_cast<const optional<T>*>(first),
+                              static_cast<const optional<T>*>(last), d_first);
+}
+
+template <typename T>
+void uninitialized_fill(optional<T>* first, optional<T>* last,
+                        const optional<T>& value) {
+  std::size_t n = static_cast<std::size_t>(last - first);
+  if constexpr (detail::bitwise_optional<T>) {
+    if (!value.has_value()) {
+      // All-zero bytes are a disengaged optional
+      if (n != 0) {
+        std::memset(static_cast<void*>(first), 0, n * sizeof(optional<T>));
+      }
+    } else {
+      for (std::size_t i = 0; i < n; ++i) {
+        std::memcpy(first + i, &value, sizeof(optional<T>));
+      }
+    }
+  } else if (!value.has_value()) {
+    for (; first != last; ++first) {
+      ::new (first) optional<T>();
+    }
+  } else {
+    optional<T>* out = first;
+    try {
+      for (; out != last; ++out) {
+        ::new (out) optional<T>(in_place, *value);
+      }
+    } catch (...) {
+      detail::destroy_engaged(first, out);
+      throw;
+    }
+  }
+}
+
+template <typename T>
+void destroy(optional<T>* first, optional<T>* last) noexcept {
+  detail::destroy_engaged(first, last);
+}
+
+/*******************************************************************************
+ *                                 Assignment                                  *
+ *******************************************************************************/
+
+// Copy-assigns [first, last) to the live elements starting at `d_first`,
+// engaging, resetting or assigning each destination as needed. Like std::copy
+// the ranges may overlap as long as `d_first` is not in [first, last), e.g.
+// to shift elements towards the front; both paths copy front to back.
+template <typename T>
+optional<T>* assign(const optional<T>* first, const optional<T>* last,
+                    optional<T>* d_first) {
+  std::size_t n = static_cast<std::size_t>(last - first);
+  if constexpr (detail::bitwise_optional<T>) {
+    if (n != 0) {
+      std::memmove(d_first, first, n * sizeof(optional<T>));
+    }
+    return d_first + n;
+  } else {
+    for (; first != last; ++first, ++d_first) {
+      if (first->has_value()) {
+        if (d_first->has_value()) {
+          **d_first = **first;
+        } else {
+          d_first->emplace(**first);
+        }
+      } else if (d_first->has_value()) {
+        d_first->reset();
+      }
+    }
+    return d_first;
+  }
+}
@@ -0,0 +1,134 @@
+#include "optional_memory.h"
+#include <benchmark/benchmark.h>
+#include <memory>
+#include <random>
+#include <string>
+#include <vector>
+
+// Copying and destroying arrays of 64k optionals that are 10% or 90% engaged
+// (argument: engaged percentage): optional_memory.h against the std::
+// algorithms, which copy and destroy element by element.
+
+namespace {
+constexpr std::size_t rows = 1 << 16;
+
+template <typename T>
+std::vector<optional<T>> make_rows(unsigned engaged_percent, T value) {
+  std::mt19937 rng(1);
+  std::vector<optional<T>> result(rows);
+  for (auto& row : result) {
+    if (rng() % 100 < engaged_percent) {
+      row = value;
+    }
+  }
+  return result;
+}
+
+std::string long_string() {
+  return std::string(48, 's');
+}
+
+template <typename T, bool use_std>
+void copy_destroy(benchmark::State& state, T value) {
+  auto source = make_rows<T>(state.range(0), value);
+  std::allocator<optional<T>> alloc;
+  optional<T>* buffer = alloc.allocate(rows);
+  for (auto _ : state) {
+    if constexpr (use_std) {
+      std::uninitialized_copy(source.data(), source.data() + rows, buffer);
+      benchmark::DoNotOptimize(buffer);
+      std::destroy(buffer, buffer + rows);
+    } else {
+      uninitialized_copy(source.data(), source.data() + rows, buffer);
+      benchmark::DoNotOptimize(buffer);
+      destroy(buffer, buffer + rows);
+    }
+    benchmark::ClobberMemory();
+  }
+  alloc.deallocate(buffer, rows);
+  state.SetItemsProcessed(state.iterations() * rows);
+}
+
+template <typename T, bool use_std>
+void fill_nullopt(benchmark::State& state) {
+  std::allocator<optional<T>> alloc;
+  optional<T>* buffer = alloc.allocate(rows);
+  for (auto _ : state) {
+    if constexpr (use_std) {
+      std::uninitialized_fill(buffer, buffer + rows, optional<T>());
+    } else {
+      uninitialized_fill(buffer, buffer + rows, optional<T>());
+    }
+    benchmark::DoNotOptimize(buffer);
+    benchmark::ClobberMemory();
+  }
+  alloc.deallocate(buffer, rows);
+  state.SetItemsProcessed(state.iterations() * rows);
+}
+
+template <typename T, bool use_std>
+void assign_arrays(benchmark::State& state, T value) {
+  auto source = make_rows<T>(state.range(0), value);
+  auto target = make_rows<T>(100 - state.range(0), value);
+  for (auto _ : state) {
+    if constexpr (use_std) {
+      std::copy(source.data(), source.data() + rows, target.data());
+    } else {
+      assign(source.data(), source.data() + rows, target.data());
+    }
+    benchmark::DoNotOptimize(target.data());
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * rows);
+}
+} // namespace
+
+static void BM_copy_destroy_int_std(benchmark::State& state) {
+  copy_destroy<int, true>(state, 42);
+}
+BENCHMARK(BM_copy_destroy_int_std)->Arg(10)->Arg(90);
+
+static void BM_copy_destroy_int(benchmark::State& state) {
+  copy_destroy<int, false>(state, 42);
+}
+BENCHMARK(BM_copy_destroy_int)->Arg(10)->Arg(90);
+
+static void BM_copy_destroy_string_std(benchmark::State& state) {
+  copy_destroy<std::string, true>(state, long_string());
+}
+BENCHMARK(BM_copy_destroy_string_std)->Arg(10)->Arg(90);
+
+static void BM_copy_destroy_string(benchmark::State& state) {
+  copy_destroy<std::string, false>(state, long_string());
+}
+BENCHMARK(BM_copy_destroy_string)->Arg(10)->Arg(90);
+
+static void BM_fill_nullopt_int_std(benchmark::State& state) {
+  fill_nullopt<int, true>(state);
+}
+BENCHMARK(BM_fill_nullopt_int_std);
+
+static void BM_fill_nullopt_int(benchmark::State& state) {
+  fill_nullopt<int, false>(state);
+}
+BENCHMARK(BM_fill_nullopt_int);
+
+static void BM_fill_nullopt_string_std(benchmark::State& state) {
+  fill_nullopt<std::string, true>(state);
+}
+BENCHMARK(BM_fill_nullopt_string_std);
+
+static void BM_fill_nullopt_string(benchmark::State& state) {
+  fill_nullopt<std::string, false>(state);
+}
+BENCHMARK(BM_fill_nullopt_string);
+
+static void BM_assign_string_std(benchmark::State& state) {
+  assign_arrays<std::string, true>(state, long_string());
+}
+BENCHMARK(BM_assign_string_std)->Arg(10)->Arg(90);
+
+static void BM_assign_string(benchmark::State& state) {
+  assign_arrays<std::string, false>(state, long_string());
+}
+BENCHMARK(BM_assign_string)->Arg(10)->Arg(90);
@@ -0,0 +1,213 @@
+#include "optional_memory.h"
+#include "gtest/gtest.h"
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace {
+// Throws from the copy constructor once `copies_left` runs out, and counts
+// live instances
+struct fragile_t {
+  static inline int live = 0;
+  static inline int copies_left = 0;
+
+  explicit fragile_t(int x_) : x{x_} {
+    ++live;
+  }
+
+  fragile_t(const fragile_t& other) : x{other.x} {
+    if (copies_left-- == 0) {
+      throw std::runtime_error("copy");
+    }
+    ++live;
+  }
+
+  fragile_t& operator=(const fragile_t&) = default;
+
+  ~fragile_t() {
+    --live;
+  }
+
+  int x;
+};
+
+// Uninitialized storage for `n` optionals
+template <typename T>
+struct raw_buffer {
+  explicit raw_buffer(std::size_t n_) : n{n_}, data{alloc.allocate(n)} {}
+
+  ~raw_buffer() {
+    alloc.deallocate(data, n);
+  }
+
+  std::allocator<optional<T>> alloc;
+  std::size_t n;
+  optional<T>* data;
+};
+
+// A generic algorithm in the payload's namespace, found through ADL like the
+// std:: one is for std::string payloads
+namespace adl {
+struct item {
+  int x;
+};
+
+inline int generic_calls = 0;
+
+template <typename InputIt, typename ForwardIt>
+ForwardIt uninitialized_copy(InputIt first, InputIt last, ForwardIt d_first) {
+  ++generic_calls;
+  return std::uninitialized_copy(first, last, d_first);
+}
+
+template <typename ForwardIt>
+void destroy(ForwardIt first, ForwardIt last) {
+  ++generic_calls;
+  std::destroy(first, last);
+}
+} // namespace adl
+
+template <typename T>
+std::vector<optional<T>> every_third_empty(std::size_t n, T value) {
+  std::vector<optional<T>> rows(n);
+  for (std::size_t i = 0; i < n; ++i) {
+    if (i % 3 != 0) {
+      rows[i] = value;
+    }
+  }
+  return rows;
+}
+} // namespace
+
+static_assert(detail::bitwise_optional<int>);
+static_assert(!detail::bitwise_optional<std::string>);
+
+TEST(optional_memory_testing, trivial_copy_and_destroy) {
+  auto rows = every_third_empty<int>(100, 5);
+  raw_buffer<int> buffer(rows.size());
+  auto end = uninitialized_copy(rows.data(), rows.data() + rows.size(),
+                                buffer.data);
+  EXPECT_EQ(buffer.data + rows.size(), end);
+  for (std::size_t i = 0; i < rows.size(); ++i) {
+    EXPECT_EQ(rows[i], buffer.data[i]);
+  }
+  destroy(buffer.data, end);
+}
+
+TEST(optional_memory_testing, trivial_fill) {
+  raw_buffer<double> buffer(50);
+  uninitialized_fill(buffer.data, buffer.data + 50, optional<double>(2.5));
+  for (std::size_t i = 0; i < 50; ++i) {
+    EXPECT_EQ(optional<double>(2.5), buffer.data[i]);
+  }
+  uninitialized_fill(buffer.data, buffer.data + 50, optional<double>());
+  for (std::size_t i = 0; i < 50; ++i) {
+    EXPECT_FALSE(buffer.data[i].has_value());
+  }
+}
+
+TEST(optional_memory_testing, copy_and_destroy) {
+  auto rows = every_third_empty<std::string>(100, std::string(40, 'x'));
+  raw_buffer<std::string> buffer(rows.size());
+  auto end = uninitialized_copy(rows.data(), rows.data() + rows.size(),
+                                buffer.data);
+  EXPECT_EQ(buffer.data + rows.size(), end);
+  for (std::size_t i = 0; i < rows.size(); ++i) {
+    EXPECT_EQ(rows[i], buffer.data[i]);
+  }
+  destroy(buffer.data, end);
+}
+
+TEST(optional_memory_testing, picked_over_adl_templates) {
+  std::vector<optional<adl::item>> rows(10);
+  rows[3] = adl::item{3};
+  raw_buffer<adl::item> buffer(rows.size());
+  optional<adl::item>* first = rows.data();
+  optional<adl::item> const* const_first = rows.data();
+
+  auto end = uninitialized_copy(first, first + rows.size(), buffer.data);
+  destroy(buffer.data, end);
+  end = uninitialized_copy(const_first, const_first + rows.size(),
+                           buffer.data);
+  EXPECT_EQ(3, buffer.data[3]->x);
+  destroy(buffer.data, end);
+  EXPECT_EQ(0, adl::generic_calls);
+}
+
+TEST(optional_memory_testing, copy_non_const_std_payloads) {
+  auto rows = every_third_empty<std::string>(30, std::string(40, 'z'));
+  raw_buffer<std::string> buffer(rows.size());
+  optional<std::string>* first = rows.data();
+  auto end = uninitialized_copy(first, first + rows.size(), buffer.data);
+  EXPECT_EQ(buffer.data + rows.size(), end);
+  for (std::size_t i = 0; i < rows.size(); ++i) {
+    EXPECT_EQ(rows[i], buffer.data[i]);
+  }
+  destroy(buffer.data, end);
+}
+
+TEST(optional_memory_testing, fill) {
+  raw_buffer<std::string> buffer(20);
+  optional<std::string> value(std::string(40, 'y'));
+  uninitialized_fill(buffer.data, buffer.data + 20, value);
+  for (std::size_t i = 0; i < 20; ++i) {
+    EXPECT_EQ(value, buffer.data[i]);
+  }
+  destroy(buffer.data, buffer.data + 20);
+
+  uninitialized_fill(buffer.data, buffer.data + 20, optional<std::string>());
+  for (std::size_t i = 0; i < 20; ++i) {
+    EXPECT_FALSE(buffer.data[i].has_value());
+  }
+  destroy(buffer.data, buffer.data + 20);
+}
+
+TEST(optional_memory_testing, assign) {
+  std::vector<optional<std::string>> from = {"a", nullopt, "c", nullopt};
+  std::vector<optional<std::string>> to = {"x", "y", nullopt, nullopt};
+  auto end = assign(from.data(), from.data() + from.size(), to.data());
+  EXPECT_EQ(to.data() + to.size(), end);
+  EXPECT_EQ(from, to);
+
+  std::vector<optional<int>> ints = {1, nullopt, 3};
+  std::vector<optional<int>> int_copy(3, 7);
+  assign(ints.data(), ints.data() + 3, int_copy.data());
+  EXPECT_EQ(ints, int_copy);
+}
+
+// Shifting towards the front overlaps source and destination
+TEST(optional_memory_testing, assign_overlapping) {
+  std::vector<optional<std::string>> strings = {"x", "a", nullopt, "c"};
+  assign(strings.data() + 1, strings.data() + 4, strings.data());
+  EXPECT_EQ((std::vector<optional<std::string>>{"a", nullopt, "c", "c"}),
+            strings);
+
+  std::vector<optional<int>> ints = {0, 1, nullopt, 3};
+  assign(ints.data() + 1, ints.data() + 4, ints.data());
+  EXPECT_EQ((std::vector<optional<int>>{1, nullopt, 3, 3}), ints);
+}
+
+TEST(optional_memory_testing, copy_rolls_back) {
+  std::vector<optional<fragile_t>> rows(10);
+  for (int i = 0; i < 10; i += 2) {
+    rows[i].emplace(i);
+  }
+  int live_before = fragile_t::live;
+  raw_buffer<fragile_t> buffer(rows.size());
+  fragile_t::copies_left = 3;
+  EXPECT_THROW(uninitialized_copy(rows.data(), rows.data() + rows.size(),
+                                  buffer.data),
+               std::runtime_error);
+  EXPECT_EQ(live_before, fragile_t::live);
+}
+
+TEST(optional_memory_testing, fill_rolls_back) {
+  optional<fragile_t> value(in_place, 1);
+  int live_before = fragile_t::live;
+  raw_buffer<fragile_t> buffer(10);
+  fragile_t::copies_left = 5;
+  EXPECT_THROW(uninitialized_fill(buffer.data, buffer.data + 10, value),
+               std::runtime_error);
+  EXPECT_EQ(live_before, fragile_t::live);
+}
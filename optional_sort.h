@@ -0,0 +1,305 @@
+#pragma once
+
+#include "optional.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <thread>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+enum class nulls_position {
+  // Same order as `operator<`, which puts nullopt before any value
+  first,
+  last,
+};
+
+enum class sort_mode {
+  sequential,
+  // Radix passes are split between `std::thread::hardware_concurrency()`
+  // threads
+  parallel,
+};
+
+namespace detail {
+/*******************************************************************************
+ *                                 Radix keys                                  *
+ *******************************************************************************/
+
+template <typename T>
+struct radix_key;
+
+template <typename T>
+  requires std::is_integral_v<T> && (!std::is_same_v<T, bool>)
+struct radix_key<T> {
+  using type = std::make_unsigned_t<T>;
+
+  static constexpr type sign = std::is_signed_v<T>
+                                   ? type(type{1} << (sizeof(T) * 8 - 1))
+                                   : type{0};
+
+  static constexpr type encode(T value) noexcept {
+    return static_cast<type>(value) ^ sign;
+  }
+
+  static constexpr T decode(type key) noexcept {
+    return static_cast<T>(key ^ sign);
+  }
+};
+
+// IEEE 754: negative numbers have all bits flipped, positive ones only the
+// sign bit, which orders -inf < ... < -0.0 < +0.0 < ... < +inf
+template <typename T>
+  requires std::is_floating_point_v<T> && std::numeric_limits<T>::is_iec559 &&
+           (sizeof(T) == 4 || sizeof(T) == 8)
+struct radix_key<T> {
+  using type =
+      std::conditional_t<sizeof(T) == 4, std::uint32_t, std::uint64_t>;
+
+  static constexpr type sign = type{1} << (sizeof(T) * 8 - 1);
+
+  static constexpr type encode(T value) noexcept {
+    auto bits = std::bit_cast<type>(value);
+    return (bits & sign) ? type(~bits) : type(bits | sign);
+  }
+
+  static constexpr T decode(type key) noexcept {
+    return std::bit_cast<T>((key & sign) ? type(key ^ sign) : type(~key));
+  }
+};
+
+template <typename Key, typename Index>
+struct keyed_index {
+  Key key;
+  Index index;
+};
+
+template <typename Key>
+constexpr Key key_of(Key key) noexcept {
+  return key;
+}
+
+template <typename Key, typename Index>
+constexpr Key key_of(const keyed_index<Key, Index>& record) noexcept {
+  return record.key;
+}
+
+/*******************************************************************************
+ *                               LSD radix sort                                *
+ *******************************************************************************/
+
+// 11-bit digits: 64-bit keys take 6 passes instead of 8 with bytes, and a
+// histogram still fits in L1
+inline constexpr std::size_t radix_bits = 11;
+inline constexpr std::size_t radix_buckets = std::size_t{1} << radix_bits;
+// Below this size the passes cost more than a comparison sort
+inline constexpr std::size_t radix_min_size = 256;
+// Below this size threads cost more than they save
+inline constexpr std::size_t radix_min_parallel_size = std::size_t{1} << 16;
+
+using radix_histogram = std::array<std::size_t, radix_buckets>;
+
+template <typename Record>
+std::size_t digit_of(const Record& record, std::size_t pass) noexcept {
+  return (key_of(record) >> (pass * radix_bits)) & (radix_buckets - 1);
+}
+
+template <typename F>
+void run_on_threads(std::size_t threads, F&& f) {
+  std::vector<std::thread> workers;
+  workers.reserve(threads - 1);
+  for (std::size_t t = 1; t < threads; ++t) {
+    workers.emplace_back([&f, t] { f(t); });
+  }
+  f(0);
+  for (auto& worker : workers) {
+    worker.join();
+  }
+}
+
+// Stable sort of `records` by key, one pass per key digit. Passes in which all
+// keys share the digit are skipped.
+//
+// Each of the `threads` threads owns a contiguous chunk of the input. A pass
+// counts the digits of every chunk, turns the counts into per-thread output
+// offsets (bucket-major, so the result stays stable) and lets every thread
+// scatter its own chunk.
+template <typename Record>
+void lsd_radix_sort(std::vector<Record>& records, sort_mode mode) {
+  using key_type = decltype(key_of(std::declval<const Record&>()));
+  constexpr std::size_t passes =
+      (sizeof(key_type) * 8 + radix_bits - 1) / radix_bits;
+  std::size_t n = records.size();
+  if (n < radix_min_size) {
+    std::stable_sort(records.begin(), records.end(),
+                     [](const Record& a, const Record& b) {
+                       return key_of(a) < key_of(b);
+                     });
+    return;
+  }
+
+  std::size_t threads = 1;
+  if (mode == sort_mode::parallel && n >= radix_min_parallel_size) {
+    threads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  auto chunk_begin = [&](std::size_t t) { return n * t / threads; };
+
+  // A single thread counts the digits of all passes in one read of the input,
+  // the counts do not depend on the order of the records
+  std::vector<radix_histogram> all_passes;
+  if (threads == 1) {
+    all_passes.resize(passes);
+    for (auto& count : all_passes) {
+      count.fill(0);
+    }
+    for (std::size_t i = 0; i < n; ++i) {
+      for (std::size_t pass = 0; pass < passes; ++pass) {
+        ++all_passes[pass][digit_of(records[i], pass)];
+      }
+    }
+  }
+
+  std::vector<Record> buffer(n);
+  Record* from = records.data();
+  Record* to = buffer.data();
+  std::vector<radix_histogram> counts(threads);
+  for (std::size_t pass = 0; pass < passes; ++pass) {
+    if (threads == 1) {
+      counts[0] = all_passes[pass];
+    } else {
+      run_on_threads(threads, [&](std::size_t t) {
+        radix_histogram& count = counts[t];
+        count.fill(0);
+        std::size_t end = chunk_begin(t + 1);
+        for (std::size_t i = chunk_begin(t); i < end; ++i) {
+          ++count[digit_of(from[i], pass)];
+        }
+      });
+    }
+
+    std::size_t same_digit = 0;
+    for (std::size_t t = 0; t < threads; ++t) {
+      same_digit += counts[t][digit_of(from[0], pass)];
+    }
+    if (same_digit == n) {
+      continue;
+    }
+
+    // counts[t][b] becomes the first output slot of bucket b for thread t
+    std::size_t offset = 0;
+    for (std::size_t b = 0; b < radix_buckets; ++b) {
+      for (std::size_t t = 0; t < threads; ++t) {
+        offset += std::exchange(counts[t][b], offset);
+      }
+    }
+
+    run_on_threads(threads, [&](std::size_t t) {
+      radix_histogram& next = counts[t];
+      std::size_t end = chunk_begin(t + 1);
+      for (std::size_t i = chunk_begin(t); i < end; ++i) {
+        to[next[digit_of(from[i], pass)]++] = from[i];
+      }
+    });
+    std::swap(from, to);
+  }
+
+  if (from != records.data()) {
+    records.swap(buffer);
+  }
+}
+} // namespace detail
+
+/*******************************************************************************
+ *                              Sorting optionals                              *
+ *******************************************************************************/
+
+// Sorts `range` into disengaged elements followed (or preceded) by the values
+// in ascending order. With `nulls_position::first` this is the order of
+// `std::sort` with `operator<`. Floating point values are ordered by their
+// bits: -0.0 sorts before +0.0 and NaNs go to the ends by their sign.
+template <typename T>
+void radix_sort(std::span<optional<T>> range,
+                nulls_position nulls = nulls_position::first,
+                sort_mode mode = sort_mode::sequential) {
+  using traits = detail::radix_key<T>;
+  std::vector<typename traits::type> keys;
+  keys.reserve(range.size());
+  for (auto const& element : range) {
+    if (element) {
+      keys.push_back(traits::encode(*element));
+    }
+  }
+  detail::lsd_radix_sort(keys, mode);
+
+  std::size_t null_count = range.size() - keys.size();
+  std::size_t first_value = nulls == nulls_position::first ? null_count : 0;
+  std::size_t first_null = nulls == nulls_position::first ? 0 : keys.size();
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    range[first_value + i] = traits::decode(keys[i]);
+  }
+  for (std::size_t i = 0; i < null_count; ++i) {
+    range[first_null + i].reset();
+  }
+}
+
+// Sorts the rows (keys[i], payloads[i]) by key, as above. The sort is stable:
+// rows with equal keys and rows with null keys keep their relative order.
+// Only the keys take part in the radix passes; each payload is moved twice,
+// into a buffer in sorted order and back. Permuting in place along cycles
+// would save one move but writes in random order, which is much slower for
+// small payloads.
+template <typename K, typename P>
+void radix_sort(std::span<optional<K>> keys, std::span<P> payloads,
+                nulls_position nulls = nulls_position::first,
+                sort_mode mode = sort_mode::sequential) {
+  assert(keys.size() == payloads.size());
+  using traits = detail::radix_key<K>;
+  using record = detail::keyed_index<typename traits::type, std::size_t>;
+  std::vector<record> records;
+  std::vector<std::size_t> null_rows;
+  records.reserve(keys.size());
+  for (std::size_t i = 0; i < keys.size(); ++i) {
+    if (keys[i]) {
+      records.push_back({traits::encode(*keys[i]), i});
+    } else {
+      null_rows.push_back(i);
+    }
+  }
+  detail::lsd_radix_sort(records, mode);
+
+  std::vector<P> sorted;
+  sorted.reserve(payloads.size());
+  auto take_nulls = [&] {
+    for (std::size_t row : null_rows) {
+      sorted.push_back(std::move(payloads[row]));
+    }
+  };
+  if (nulls == nulls_position::first) {
+    take_nulls();
+  }
+  for (auto const& r : records) {
+    sorted.push_back(std::move(payloads[r.index]));
+  }
+  if (nulls == nulls_position::last) {
+    take_nulls();
+  }
+  std::move(sorted.begin(), sorted.end(), payloads.begin());
+
+  std::size_t first_value =
+      nulls == nulls_position::first ? null_rows.size() : 0;
+  std::size_t first_null =
+      nulls == nulls_position::first ? 0 : records.size();
+  for (std::size_t i = 0; i < records.size(); ++i) {
+    keys[first_value + i] = traits::decode(records[i].key);
+  }
+  for (std::size_t i = 0; i < null_rows.size(); ++i) {
+    keys[first_null + i].reset();
+  }
+}
@@ -0,0 +1,107 @@
+#include "optional_sort.h"
+#include <benchmark/benchmark.h>
+#include <algorithm>
+#include <cstdint>
+#include <random>
+#include <span>
+#include <vector>
+
+// Sorting 10M `optional<uint64_t>` keys with 0%, 10% and 50% nulls:
+// `std::sort` with `operator<` against the radix sort, sequential and
+// parallel, and the key-payload variant against sorting pairs.
+
+namespace {
+constexpr std::size_t rows = 10'000'000;
+
+std::vector<optional<std::uint64_t>> random_keys(unsigned null_percent) {
+  std::mt19937_64 rng(42);
+  std::vector<optional<std::uint64_t>> keys(rows);
+  for (auto& key : keys) {
+    if (rng() % 100 >= null_percent) {
+      key = rng();
+    }
+  }
+  return keys;
+}
+
+template <typename Sort>
+void run_sort(benchmark::State& state, Sort sort) {
+  auto input = random_keys(static_cast<unsigned>(state.range(0)));
+  std::vector<optional<std::uint64_t>> keys(rows);
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::copy(input.begin(), input.end(), keys.begin());
+    state.ResumeTiming();
+    sort(keys);
+    benchmark::DoNotOptimize(keys.data());
+  }
+  state.SetItemsProcessed(state.iterations() * rows);
+}
+} // namespace
+
+static void BM_sort_std(benchmark::State& state) {
+  run_sort(state, [](auto& keys) { std::sort(keys.begin(), keys.end()); });
+}
+BENCHMARK(BM_sort_std)
+    ->Arg(0)
+    ->Arg(10)
+    ->Arg(50)
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_sort_radix(benchmark::State& state) {
+  run_sort(state, [](auto& keys) { radix_sort(std::span(keys)); });
+}
+BENCHMARK(BM_sort_radix)
+    ->Arg(0)
+    ->Arg(10)
+    ->Arg(50)
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_sort_radix_parallel(benchmark::State& state) {
+  run_sort(state, [](auto& keys) {
+    radix_sort(std::span(keys), nulls_position::first, sort_mode::parallel);
+  });
+}
+BENCHMARK(BM_sort_radix_parallel)
+    ->Arg(0)
+    ->Arg(10)
+    ->Arg(50)
+    ->Unit(benchmark::kMillisecond);
+
+static void BM_sort_pairs_std(benchmark::State& state) {
+  auto input = random_keys(static_cast<unsigned>(state.range(0)));
+  using row = std::pair<optional<std::uint64_t>, std::uint32_t>;
+  std::vector<row> pairs(rows);
+  for (auto _ : state) {
+    state.PauseTiming();
+    for (std::size_t i = 0; i < rows; ++i) {
+      pairs[i] = {input[i], static_cast<std::uint32_t>(i)};
+    }
+    state.ResumeTiming();
+    std::stable_sort(pairs.begin(), pairs.end(),
+                     [](const row& a, const row& b) {
+                       return a.first < b.first;
+                     });
+    benchmark::DoNotOptimize(pairs.data());
+  }
+  state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK(BM_sort_pairs_std)->Arg(10)->Unit(benchmark::kMillisecond);
+
+static void BM_sort_pairs_radix(benchmark::State& state) {
+  auto input = random_keys(static_cast<unsigned>(state.range(0)));
+  std::vector<optional<std::uint64_t>> keys(rows);
+  std::vector<std::uint32_t> payloads(rows);
+  for (auto _ : state) {
+    state.PauseTiming();
+    std::copy(input.begin(), input.end(), keys.begin());
+    for (std::size_t i = 0; i < rows; ++i) {
+      payloads[i] = static_cast<std::uint32_t>(i);
+    }
+    state.ResumeTiming();
+    radix_sort(std::span(keys), std::span(payloads));
+    benchmark::DoNotOptimize(payloads.data());
+  }
+  state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK(BM_sort_pairs_radix)->Arg(10)->Unit(benchmark::kMillisecond);
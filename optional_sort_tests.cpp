@@ -0,0 +1,162 @@
+#include "optional_sort.h"
+#include "test_classes.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <random>
+#include <span>
+#include <string>
+#include <vector>
+
+namespace {
+template <typename T>
+std::vector<optional<T>> random_rows(std::size_t count, unsigned null_percent,
+                                     T low, T high) {
+  std::mt19937_64 rng(count);
+  std::vector<optional<T>> rows(count);
+  for (auto& row : rows) {
+    if (rng() % 100 >= null_percent) {
+      if constexpr (std::is_floating_point_v<T>) {
+        row = std::uniform_real_distribution<T>(low, high)(rng);
+      } else {
+        using wide = std::conditional_t<std::is_signed_v<T>, long long,
+                                        unsigned long long>;
+        std::uniform_int_distribution<wide> values(low, high);
+        row = static_cast<T>(values(rng));
+      }
+    }
+  }
+  return rows;
+}
+
+// std::stable_sort with `operator<`, then the nulls moved to the back
+template <typename T>
+std::vector<optional<T>> reference_sort(std::vector<optional<T>> rows,
+                                        nulls_position nulls) {
+  std::stable_sort(rows.begin(), rows.end());
+  if (nulls == nulls_position::last) {
+    std::stable_partition(rows.begin(), rows.end(), [](const optional<T>& row) {
+      return row.has_value();
+    });
+  }
+  return rows;
+}
+
+template <typename T>
+void expect_sorted(std::vector<optional<T>> rows, sort_mode mode) {
+  for (auto nulls : {nulls_position::first, nulls_position::last}) {
+    auto expected = reference_sort(rows, nulls);
+    auto actual = rows;
+    radix_sort(std::span(actual), nulls, mode);
+    EXPECT_EQ(expected, actual);
+  }
+}
+} // namespace
+
+TEST(optional_sort_testing, unsigned_keys) {
+  expect_sorted(random_rows<std::uint64_t>(
+                    10'000, 10, 0, std::numeric_limits<std::uint64_t>::max()),
+                sort_mode::sequential);
+  expect_sorted(random_rows<std::uint16_t>(10'000, 30, 0, 1000),
+                sort_mode::sequential);
+}
+
+TEST(optional_sort_testing, signed_keys) {
+  expect_sorted(random_rows<std::int32_t>(10'000, 10, -1000, 1000),
+                sort_mode::sequential);
+  expect_sorted(random_rows<std::int64_t>(
+                    10'000, 50, std::numeric_limits<std::int64_t>::min(),
+                    std::numeric_limits<std::int64_t>::max()),
+                sort_mode::sequential);
+  expect_sorted(random_rows<signed char>(1'000, 10, -128, 127),
+                sort_mode::sequential);
+}
+
+TEST(optional_sort_testing, floating_point_keys) {
+  expect_sorted(random_rows<double>(10'000, 10, -1e9, 1e9),
+                sort_mode::sequential);
+  expect_sorted(random_rows<float>(10'000, 10, -1.0f, 1.0f),
+                sort_mode::sequential);
+
+  constexpr double inf = std::numeric_limits<double>::infinity();
+  std::vector<optional<double>> rows = {2.5, inf, nullopt, -0.0, -inf, 0.0,
+                                        -2.5};
+  radix_sort(std::span(rows));
+  std::vector<optional<double>> expected = {nullopt, -inf, -2.5, -0.0,
+                                            0.0,     2.5,  inf};
+  EXPECT_EQ(expected, rows);
+  EXPECT_TRUE(std::signbit(*rows[3]));
+  EXPECT_FALSE(std::signbit(*rows[4]));
+}
+
+TEST(optional_sort_testing, small_and_edge_inputs) {
+  std::vector<optional<int>> empty;
+  radix_sort(std::span(empty));
+  EXPECT_TRUE(empty.empty());
+
+  std::vector<optional<int>> all_null(1000);
+  radix_sort(std::span(all_null), nulls_position::last);
+  EXPECT_TRUE(std::none_of(all_null.begin(), all_null.end(),
+                           [](const optional<int>& row) {
+                             return row.has_value();
+                           }));
+
+  expect_sorted(random_rows<int>(10, 20, -5, 5), sort_mode::sequential);
+  expect_sorted(std::vector<optional<int>>(5000, 7), sort_mode::sequential);
+}
+
+TEST(optional_sort_testing, parallel) {
+  expect_sorted(random_rows<std::uint64_t>(
+                    300'000, 10, 0, std::numeric_limits<std::uint64_t>::max()),
+                sort_mode::parallel);
+  expect_sorted(random_rows<double>(300'000, 50, -1.0, 1.0),
+                sort_mode::parallel);
+}
+
+TEST(optional_sort_testing, key_payload_pairs) {
+  for (auto mode : {sort_mode::sequential, sort_mode::parallel}) {
+    for (auto nulls : {nulls_position::first, nulls_position::last}) {
+      auto keys = random_rows<int>(100'000, 20, 0, 100);
+      std::vector<std::size_t> payloads(keys.size());
+      for (std::size_t i = 0; i < payloads.size(); ++i) {
+        payloads[i] = i;
+      }
+      auto original = keys;
+      radix_sort(std::span(keys), std::span(payloads), nulls, mode);
+
+      EXPECT_EQ(reference_sort(original, nulls), keys);
+      for (std::size_t i = 0; i < keys.size(); ++i) {
+        // Payloads travel with their keys
+        ASSERT_EQ(original[payloads[i]], keys[i]);
+        // Equal keys and null keys keep their order
+        if (i > 0 && keys[i] == keys[i - 1]) {
+          ASSERT_LT(payloads[i - 1], payloads[i]);
+        }
+      }
+    }
+  }
+}
+
+TEST(optional_sort_testing, key_payload_pairs_strings) {
+  std::vector<optional<int>> keys = {3, nullopt, 1, 2};
+  std::vector<std::string> payloads = {"three", "null", "one", "two"};
+  radix_sort(std::span(keys), std::span(payloads), nulls_position::last);
+  EXPECT_EQ((std::vector<std::string>{"one", "two", "three", "null"}),
+            payloads);
+}
+
+TEST(optional_sort_testing, key_payload_moves) {
+  // Payloads are moved into a buffer and back, never copied
+  std::vector<optional<int>> keys = {1, 3, 2, 0, 5, 4};
+  std::vector<counting_t> payloads = {"1", "3", "2", "0", "5", "4"};
+  counting_t::count = {};
+  radix_sort(std::span(keys), std::span(payloads));
+  EXPECT_EQ(payloads.size(), counting_t::count.moved);
+  EXPECT_EQ(payloads.size(), counting_t::count.move_assigned);
+  EXPECT_EQ(0, counting_t::count.copied + counting_t::count.copy_assigned);
+  for (std::size_t i = 0; i < payloads.size(); ++i) {
+    EXPECT_EQ(std::to_string(i), payloads[i].text);
+  }
+}
@@ -0,0 +1,408 @@
+#pragma once
+
+#include "member_switches.h"
+#include "optional_bases.h"
+
+#include <array>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <tuple>
+
+namespace detail {
+/*******************************************************************************
+ *                              Presence bitmask                               *
+ *******************************************************************************/
+
+// Smallest unsigned word that has a bit for every field
+template <std::size_t N>
+using presence_mask_t = std::conditional_t<
+    N <= 8, std::uint8_t,
+    std::conditional_t<N <= 16, std::uint16_t,
+                       std::conditional_t<N <= 32, std::uint32_t,
+                                          std::uint64_t>>>;
+
+template <typename F, std::size_t... Is>
+constexpr void for_each_index(std::index_sequence<Is...>, F&& f) {
+  (f(std::integral_constant<std::size_t, Is>{}), ...);
+}
+
+/*******************************************************************************
+ *                                Payload slots                                *
+ *******************************************************************************/
+
+// Raw storage for one field. Whether it holds a live object is decided by the
+// owner's presence bitmask, not by the slot itself.
+template <typename T, bool trivial = std::is_trivially_destructible_v<T>>
+union packed_slot {
+  char dummy;
+  T value;
+
+  constexpr packed_slot() noexcept : dummy{} {}
+  constexpr ~packed_slot() {}
+};
+
+template <typename T>
+union packed_slot<T, true> {
+  char dummy;
+  T value;
+
+  constexpr packed_slot() noexcept : dummy{} {}
+  // No user defined destructor => trivial
+};
+
+// Payloads laid out in template argument order
+template <typename T, typename... Ts>
+struct packed_slots {
+  packed_slot<T> head;
+  packed_slots<Ts...> tail;
+};
+
+template <typename T>
+struct packed_slots<T> {
+  packed_slot<T> head;
+};
+
+template <std::size_t I, typename Slots>
+constexpr auto& slot_at(Slots& slots) noexcept {
+  if constexpr (I == 0) {
+    return slots.head;
+  } else {
+    return slot_at<I - 1>(slots.tail);
+  }
+}
+
+// Fields are stored sorted by decreasing alignment (stable for equal ones), so
+// that nesting the slots never introduces padding between payloads. The mask
+// bits keep following the declaration order.
+template <typename... Ts>
+struct packed_layout {
+  static constexpr std::size_t size = sizeof...(Ts);
+
+  // order[k] is the declaration index of the field stored at position k
+  static constexpr std::array<std::size_t, size> order = [] {
+    std::array<std::size_t, size> alignments{alignof(Ts)...};
+    std::array<std::size_t, size> result{};
+    for (std::size_t i = 0; i < size; ++i) {
+      std::size_t j = i;
+      for (; j > 0 && alignments[result[j - 1]] < alignments[i]; --j) {
+        result[j] = result[j - 1];
+      }
+      result[j] = i;
+    }
+    return result;
+  }();
+
+  // position[i] is where the field declared at index i is stored
+  static constexpr std::array<std::size_t, size> position = [] {
+    std::array<std::size_t, size> result{};
+    for (std::size_t k = 0; k < size; ++k) {
+      result[order[k]] = k;
+    }
+    return result;
+  }();
+
+  template <typename Seq>
+  struct sorted;
+
+  template <std::size_t... Ks>
+  struct sorted<std::index_sequence<Ks...>> {
+    using type =
+        packed_slots<std::tuple_element_t<order[Ks], std::tuple<Ts...>>...>;
+  };
+
+  using slots = typename sorted<std::make_index_sequence<size>>::type;
+};
+
+/*******************************************************************************
+ *                          Storage & lifetime logic                           *
+ *******************************************************************************/
+
+// Storage of all fields for the triviality chain of `optional_bases.h`: each
+// special member of a `packed_optionals` is trivial when it is trivial for
+// every field.
+template <typename... Ts>
+struct packed_storage_ops {
+  using payloads = payload_list<Ts...>;
+  using mask_type = presence_mask_t<sizeof...(Ts)>;
+  using indices = std::index_sequence_for<Ts...>;
+  using layout = packed_layout<Ts...>;
+
+  mask_type mask{0};
+  typename layout::slots slots;
+
+  template <std::size_t I>
+  static constexpr mask_type bit = static_cast<mask_type>(mask_type{1} << I);
+
+  template <std::size_t I>
+  constexpr bool engaged() const noexcept {
+    return (mask & bit<I>) != 0;
+  }
+
+  template <std::size_t I>
+  constexpr auto& payload() noexcept {
+    return slot_at<layout::position[I]>(slots).value;
+  }
+
+  template <std::size_t I>
+  constexpr auto const& payload() const noexcept {
+    return slot_at<layout::position[I]>(slots).value;
+  }
+
+  template <std::size_t I, typename... Args>
+  constexpr void construct(Args&&... args) {
+    std::construct_at(&payload<I>(), std::forward<Args>(args)...);
+    mask |= bit<I>;
+  }
+
+  template <std::size_t I>
+  constexpr void destroy() noexcept {
+    using T = std::tuple_element_t<I, std::tuple<Ts...>>;
+    if constexpr (!std::is_trivially_destructible_v<T>) {
+      if (engaged<I>()) {
+        std::destroy_at(&payload<I>());
+      }
+    }
+    mask &= static_cast<mask_type>(~bit<I>);
+  }
+
+  constexpr void reset_all() noexcept {
+    if constexpr ((std::is_trivially_destructible_v<Ts> && ...)) {
+      mask = 0;
+    } else {
+      for_each_index(indices{},
+                     [this](auto i) { destroy<decltype(i)::value>(); });
+    }
+  }
+
+  constexpr packed_storage_ops() noexcept = default;
+
+  // Fields that are trivially destructible need no cleanup if a later one
+  // throws
+  template <typename Other>
+  constexpr packed_storage_ops(from_storage_t, Other&& other) {
+    construct_from(std::forward<Other>(other));
+  }
+
+  template <typename Other>
+  constexpr void construct_from(Other&& other) {
+    for_each_index(indices{}, [&](auto i) {
+      constexpr std::size_t I = decltype(i)::value;
+      if (other.template engaged<I>()) {
+        construct<I>(
+            std::forward<Other>(other).template forward_payload<I>());
+      }
+    });
+  }
+
+  template <typename Other>
+  constexpr void assign_from(Other&& other) {
+    for_each_index(indices{}, [&](auto i) {
+      constexpr std::size_t I = decltype(i)::value;
+      if (!other.template engaged<I>()) {
+        destroy<I>();
+      } else if (engaged<I>()) {
+        payload<I>() =
+            std::forward<Other>(other).template forward_payload<I>();
+      } else {
+        construct<I>(
+            std::forward<Other>(other).template forward_payload<I>());
+      }
+    });
+  }
+
+  template <std::size_t I>
+  constexpr auto const& forward_payload() const& noexcept {
+    return payload<I>();
+  }
+
+  template <std::size_t I>
+  constexpr auto&& forward_payload() && noexcept {
+    return std::move(payload<I>());
+  }
+};
+
+template <bool trivial, typename... Ts>
+struct packed_storage_base : packed_storage_ops<Ts...> {
+  constexpr packed_storage_base() noexcept = default;
+
+  // Delegating, so that the destructor destroys the fields built before one
+  // that throws
+  template <typename Other>
+  constexpr packed_storage_base(from_storage_t, Other&& other)
+      : packed_storage_base() {
+    this->construct_from(std::forward<Other>(other));
+  }
+
+  constexpr ~packed_storage_base() {
+    this->reset_all();
+  }
+};
+
+template <typename... Ts>
+struct packed_storage_base<true, Ts...> : packed_storage_ops<Ts...> {
+  using packed_storage_ops<Ts...>::packed_storage_ops;
+
+  // No user defined destructor => trivial
+};
+
+template <typename... Ts>
+using packed_storage =
+    packed_storage_base<(std::is_trivially_destructible_v<Ts> && ...), Ts...>;
+
+} // namespace detail
+
+/*******************************************************************************
+ *                              Packed optionals                               *
+ *******************************************************************************/
+
+template <typename Packed, std::size_t I>
+class packed_field;
+
+// A record of optional fields that shares a single presence bitmask instead of
+// paying a `bool` plus padding per field. Payloads are reordered by alignment
+// internally; fields are still addressed by their declaration index.
+template <typename... Ts>
+class packed_optionals
+    : private detail::move_assign_base<detail::packed_storage<Ts...>>,
+      private detail::enable_copy_construction<(
+          std::is_copy_constructible_v<Ts> && ...)>,
+      private detail::enable_copy_assignment<(
+          (std::is_copy_assignable_v<Ts> &&
+           std::is_copy_constructible_v<Ts>)&&...)>,
+      private detail::enable_move_construction<(
+          std::is_move_constructible_v<Ts> && ...)>,
+      private detail::enable_move_assignment<(
+          (std::is_move_assignable_v<Ts> &&
+           std::is_move_constructible_v<Ts>)&&...)> {
+  static_assert(sizeof...(Ts) > 0, "packed_optionals needs at least one field");
+  static_assert(sizeof...(Ts) <= 64, "presence mask is limited to 64 fields");
+
+  using base = detail::move_assign_base<detail::packed_storage<Ts...>>;
+
+public:
+  using mask_type = typename base::mask_type;
+
+  template <std::size_t I>
+  using element_type = std::tuple_element_t<I, std::tuple<Ts...>>;
+
+  constexpr packed_optionals() noexcept = default;
+
+  static constexpr std::size_t size() noexcept {
+    return sizeof...(Ts);
+  }
+
+  template <std::size_t I>
+  constexpr bool has_value() const noexcept {
+    return this->template engaged<I>();
+  }
+
+  // Unchecked access, same contract as `optional::operator*`
+  template <std::size_t I>
+  constexpr element_type<I>& get() noexcept {
+    assert(has_value<I>());
+    return this->template payload<I>();
+  }
+
+  template <std::size_t I>
+  constexpr element_type<I> const& get() const noexcept {
+    assert(has_value<I>());
+    return this->template payload<I>();
+  }
+
+  template <std::size_t I, typename... Args>
+  constexpr element_type<I>& emplace(Args&&... args) {
+    reset<I>();
+    this->template construct<I>(std::forward<Args>(args)...);
+    return this->template payload<I>();
+  }
+
+  template <std::size_t I>
+  constexpr void reset() noexcept {
+    this->template destroy<I>();
+  }
+
+  constexpr void reset_all() noexcept {
+    base::reset_all();
+  }
+
+  constexpr mask_type mask() const noexcept {
+    return this->base::mask;
+  }
+
+  constexpr std::size_t count_engaged() const noexcept {
+    return static_cast<std::size_t>(std::popcount(this->base::mask));
+  }
+
+  template <std::size_t I>
+  constexpr packed_field<packed_optionals, I> field() noexcept {
+    return packed_field<packed_optionals, I>{*this};
+  }
+
+  template <std::size_t I>
+  constexpr packed_field<const packed_optionals, I> field() const noexcept {
+    return packed_field<const packed_optionals, I>{*this};
+  }
+};
+
+template <typename... Ts>
+using optional_tuple = packed_optionals<Ts...>;
+
+/*******************************************************************************
+ *                          Per-field optional view                            *
+ *******************************************************************************/
+
+// `optional`-like handle to a single field of a `packed_optionals`
+template <typename Packed, std::size_t I>
+class packed_field {
+  using record = std::remove_const_t<Packed>;
+  using T = typename record::template element_type<I>;
+  using reference = std::conditional_t<std::is_const_v<Packed>, T const&, T&>;
+
+public:
+  constexpr explicit packed_field(Packed& owner_) noexcept : owner{owner_} {}
+
+  constexpr explicit operator bool() const noexcept {
+    return has_value();
+  }
+
+  [[nodiscard]] constexpr bool has_value() const noexcept {
+    return owner.template has_value<I>();
+  }
+
+  constexpr reference operator*() const noexcept {
+    return owner.template get<I>();
+  }
+
+  constexpr std::remove_reference_t<reference>* operator->() const noexcept {
+    return &owner.template get<I>();
+  }
+
+  template <typename... Args>
+  constexpr T& emplace(Args&&... args) const {
+    return owner.template emplace<I>(std::forward<Args>(args)...);
+  }
+
+  constexpr void reset() const noexcept {
+    owner.template reset<I>();
+  }
+
+  constexpr const packed_field& operator=(nullopt_t) const noexcept {
+    reset();
+    return *this;
+  }
+
+private:
+  Packed& owner;
+};
+
+template <std::size_t I, typename... Ts>
+constexpr auto& get(packed_optionals<Ts...>& p) noexcept {
+  return p.template get<I>();
+}
+
+template <std::size_t I, typename... Ts>
+constexpr auto const& get(packed_optionals<Ts...> const& p) noexcept {
+  return p.template get<I>();
+}
@@ -0,0 +1,198 @@
+#include "packed_optionals.h"
+#include "optional.h"
+#include "test_classes.h"
+#include "test_object.h"
+#include "gtest/gtest.h"
+#include <memory>
+#include <string>
+
+namespace {
+using record = packed_optionals<int, double, char, short, float, long long>;
+
+struct unpacked_record {
+  optional<int> a;
+  optional<double> b;
+  optional<char> c;
+  optional<short> d;
+  optional<float> e;
+  optional<long long> f;
+};
+} // namespace
+
+TEST(packed_optionals_testing, default_ctor) {
+  record r;
+  EXPECT_EQ(0, r.count_engaged());
+  EXPECT_FALSE(r.has_value<0>());
+  EXPECT_FALSE(r.has_value<5>());
+  EXPECT_FALSE(static_cast<bool>(r.field<1>()));
+}
+
+TEST(packed_optionals_testing, smaller_than_separate_optionals) {
+  EXPECT_LT(sizeof(record), sizeof(unpacked_record));
+  EXPECT_EQ(sizeof(std::uint8_t), sizeof(record::mask_type));
+  EXPECT_EQ(sizeof(std::uint64_t),
+            sizeof(packed_optionals<int, int, int, int, int, int, int, int,
+                                    int, int, int, int, int, int, int, int, int,
+                                    int, int, int, int, int, int, int, int, int,
+                                    int, int, int, int, int, int, int>::
+                       mask_type));
+}
+
+TEST(packed_optionals_testing, emplace_and_get) {
+  record r;
+  r.emplace<0>(42);
+  r.emplace<3>(short{7});
+  EXPECT_TRUE(r.has_value<0>());
+  EXPECT_FALSE(r.has_value<1>());
+  EXPECT_TRUE(r.has_value<3>());
+  EXPECT_EQ(42, r.get<0>());
+  EXPECT_EQ(7, get<3>(std::as_const(r)));
+  EXPECT_EQ(2, r.count_engaged());
+  EXPECT_EQ(0b1001, r.mask());
+}
+
+TEST(packed_optionals_testing, field_view) {
+  record r;
+  auto f = r.field<1>();
+  EXPECT_FALSE(f.has_value());
+  f.emplace(1.5);
+  EXPECT_TRUE(static_cast<bool>(f));
+  EXPECT_EQ(1.5, *f);
+  *f = 2.5;
+  EXPECT_EQ(2.5, *std::as_const(r).field<1>());
+  f = nullopt;
+  EXPECT_FALSE(r.has_value<1>());
+}
+
+TEST(packed_optionals_testing, reset) {
+  test_object::no_new_instances_guard g;
+  packed_optionals<test_object, int, test_object> r;
+  r.emplace<0>(1);
+  r.emplace<1>(2);
+  r.emplace<2>(3);
+  r.reset<0>();
+  EXPECT_FALSE(r.has_value<0>());
+  EXPECT_EQ(3, r.get<2>());
+  r.reset_all();
+  EXPECT_EQ(0, r.count_engaged());
+  g.expect_no_instances();
+}
+
+TEST(packed_optionals_testing, dtor) {
+  test_object::no_new_instances_guard g;
+  packed_optionals<test_object, std::string> r;
+  r.emplace<0>(42);
+  r.emplace<1>("a string that does not fit into the small buffer");
+}
+
+TEST(packed_optionals_testing, copy_ctor) {
+  test_object::no_new_instances_guard g;
+  packed_optionals<test_object, int, test_object> a;
+  a.emplace<0>(42);
+  a.emplace<1>(5);
+  packed_optionals<test_object, int, test_object> b = a;
+  EXPECT_EQ(a.mask(), b.mask());
+  EXPECT_EQ(42, b.get<0>());
+  EXPECT_EQ(5, b.get<1>());
+  EXPECT_FALSE(b.has_value<2>());
+}
+
+TEST(packed_optionals_testing, move_ctor) {
+  packed_optionals<std::unique_ptr<int>, int> a;
+  a.emplace<0>(std::make_unique<int>(42));
+  packed_optionals<std::unique_ptr<int>, int> b = std::move(a);
+  ASSERT_TRUE(b.has_value<0>());
+  EXPECT_EQ(42, *b.get<0>());
+  EXPECT_FALSE(b.has_value<1>());
+}
+
+TEST(packed_optionals_testing, assignment) {
+  test_object::no_new_instances_guard g;
+  packed_optionals<test_object, test_object, test_object> a, b;
+  a.emplace<0>(1);
+  a.emplace<1>(2);
+  b.emplace<1>(20);
+  b.emplace<2>(30);
+  a = b;
+  EXPECT_FALSE(a.has_value<0>());
+  EXPECT_EQ(20, a.get<1>());
+  EXPECT_EQ(30, a.get<2>());
+  a = std::move(b);
+  EXPECT_EQ(b.mask(), a.mask());
+}
+
+namespace {
+struct throw_on_copy {
+  throw_on_copy() = default;
+  throw_on_copy(const throw_on_copy&) {
+    throw std::exception();
+  }
+};
+} // namespace
+
+TEST(packed_optionals_testing, copy_ctor_rollback) {
+  test_object::no_new_instances_guard g;
+  packed_optionals<test_object, throw_on_copy> a;
+  a.emplace<0>(1);
+  a.emplace<1>();
+  using packed = packed_optionals<test_object, throw_on_copy>;
+  EXPECT_THROW(packed{a}, std::exception);
+}
+
+TEST(traits, packed_optionals) {
+  using packed1 = packed_optionals<int, double, dummy_t>;
+  using packed2 = packed_optionals<int, std::string>;
+  using packed3 = packed_optionals<int, no_copy_t>;
+  using packed4 = packed_optionals<no_move_t>;
+  using packed5 = packed_optionals<int, no_copy_assignment_t>;
+  ASSERT_TRUE(std::is_trivially_copyable_v<packed1>);
+  ASSERT_TRUE(std::is_trivially_destructible_v<packed1>);
+  ASSERT_FALSE(std::is_trivially_copyable_v<packed2>);
+  ASSERT_TRUE(std::is_copy_constructible_v<packed2>);
+  ASSERT_FALSE(std::is_copy_constructible_v<packed3>);
+  ASSERT_FALSE(std::is_move_constructible_v<packed4>);
+  ASSERT_FALSE(std::is_copy_assignable_v<packed5>);
+}
+
+// Each special member is trivial when it is trivial for every field
+TEST(traits, packed_optionals_per_operation) {
+  using packed1 = packed_optionals<int, non_trivial_copy_assignment_t>;
+  using packed2 = packed_optionals<char, non_trivial_copy_t>;
+  ASSERT_TRUE(std::is_trivially_destructible_v<packed1>);
+  ASSERT_TRUE(std::is_trivially_copy_constructible_v<packed1>);
+  ASSERT_TRUE(std::is_trivially_move_constructible_v<packed1>);
+  ASSERT_FALSE(std::is_trivially_copy_assignable_v<packed1>);
+  ASSERT_TRUE(std::is_trivially_destructible_v<packed2>);
+  ASSERT_FALSE(std::is_trivially_copy_constructible_v<packed2>);
+}
+
+TEST(packed_optionals_testing, emplace_direct_init) {
+  packed_optionals<std::string, int> r;
+  r.emplace<0>(3, 'x');
+  EXPECT_EQ("xxx", r.get<0>());
+
+  packed_optionals<non_trivial_copy_assignment_t> a, b;
+  a.emplace<0>(1);
+  b.emplace<0>(2);
+  a = b;
+  EXPECT_EQ(7, a.get<0>().x);
+}
+
+static_assert([] {
+  packed_optionals<int, char> a;
+  return a.count_engaged() == 0 && !a.has_value<1>();
+}());
+
+// Fields that are not trivially destructible are destroyed and reset in
+// constant evaluation too
+static_assert([] {
+  packed_optionals<std::string, int> a;
+  a.emplace<0>(3, 'x');
+  a.emplace<1>(1);
+  bool engaged = a.get<0>() == "xxx" && a.count_engaged() == 2;
+  a.reset<0>();
+  a.field<1>() = nullopt;
+  a.emplace<0>("again");
+  a.reset_all();
+  return engaged && a.count_engaged() == 0;
+}());
@@ -0,0 +1,186 @@
+#pragma once
+
+#include "optional.h"
+
+#include <algorithm>
+#include <array>
+#include <bit>
+#include <concepts>
+#include <cstddef>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+#include <utility>
+
+namespace detail {
+/*******************************************************************************
+ *                                 Key hashing                                 *
+ *******************************************************************************/
+
+// splitmix64 finalizer, a bijection on 64-bit words
+constexpr std::uint64_t mix_hash(std::uint64_t x) noexcept {
+  x ^= x >> 30;
+  x *= 0xbf58476d1ce4e5b9ull;
+  x ^= x >> 27;
+  x *= 0x94d049bb133111ebull;
+  x ^= x >> 31;
+  return x;
+}
+
+// Odd multiplier and xorshift, both bijections: distinct integer keys never
+// collide
+template <std::integral K>
+constexpr std::uint64_t perfect_hash_key(K key) noexcept {
+  std::uint64_t x = static_cast<std::uint64_t>(key) * 0x9e3779b97f4a7c15ull;
+  return x ^ (x >> 32);
+}
+
+// 64-bit FNV-1a
+constexpr std::uint64_t perfect_hash_key(std::string_view key) noexcept {
+  std::uint64_t state = 14695981039346656037ull;
+  for (char c : key) {
+    state = (state ^ static_cast<unsigned char>(c)) * 1099511628211ull;
+  }
+  return mix_hash(state);
+}
+
+// Slot of a key hash under a bucket's displacement, in the top `bits` bits
+constexpr std::size_t displaced_slot(std::uint64_t hash,
+                                     std::uint32_t displacement,
+                                     int bits) noexcept {
+  std::uint64_t x = (hash ^ displacement) * 0xd6e8feb86659fd93ull;
+  return static_cast<std::size_t>(x >> (64 - bits));
+}
+} // namespace detail
+
+/*******************************************************************************
+ *                              Perfect hash map                               *
+ *******************************************************************************/
+
+// Immutable map from a fixed set of N keys (integers or string_views), meant
+// to be built in constant evaluation:
+//
+//   constexpr auto codes = make_perfect_hash_map<int, descriptor>({
+//       {404, {"not found", 1}},
+//       {500, {"internal error", 2}},
+//   });
+//
+// A `constexpr` table is laid out by the compiler, so it costs nothing at
+// startup and never allocates. Lookups hash the key once and probe exactly one
+// slot (hash and displace): keys are split into buckets of about four, and
+// each bucket stores the displacement that sends all of its keys to free
+// slots. Duplicate keys make the construction throw, which is a compile error
+// in constant evaluation.
+template <typename K, typename V, std::size_t N>
+class perfect_hash_map {
+  static_assert(N > 0, "a perfect hash map needs at least one key");
+
+public:
+  using key_type = K;
+  using mapped_type = V;
+  using value_type = std::pair<K, V>;
+
+  // At most half of the slots are used, which keeps the displacement search
+  // short
+  static constexpr std::size_t slot_count = std::bit_ceil(2 * N);
+  static constexpr std::size_t bucket_count = std::bit_ceil((N + 3) / 4);
+
+  constexpr explicit perfect_hash_map(const value_type (&entries)[N]) {
+    std::array<std::uint64_t, N> hashes{};
+    std::array<std::size_t, N> order{};
+    std::array<std::size_t, bucket_count> bucket_sizes{};
+    for (std::size_t i = 0; i < N; ++i) {
+      hashes[i] = detail::perfect_hash_key(entries[i].first);
+      order[i] = i;
+      ++bucket_sizes[bucket_of(hashes[i])];
+    }
+    // Largest buckets first, they are the hardest to place
+    std::sort(order.begin(), order.end(), [&](std::size_t a, std::size_t b) {
+      std::size_t bucket_a = bucket_of(hashes[a]);
+      std::size_t bucket_b = bucket_of(hashes[b]);
+      if (bucket_sizes[bucket_a] != bucket_sizes[bucket_b]) {
+        return bucket_sizes[bucket_a] > bucket_sizes[bucket_b];
+      }
+      return bucket_a < bucket_b;
+    });
+
+    for (std::size_t first = 0; first < N;) {
+      std::size_t bucket = bucket_of(hashes[order[first]]);
+      std::size_t last = first + bucket_sizes[bucket];
+      for (std::size_t i = first; i < last; ++i) {
+        for (std::size_t j = first; j < i; ++j) {
+          if (hashes[order[i]] == hashes[order[j]]) {
+            throw std::invalid_argument(
+                "perfect_hash_map: duplicate key or hash collision");
+          }
+        }
+      }
+      displacements[bucket] = place(entries, hashes, order, first, last);
+      first = last;
+    }
+  }
+
+  constexpr optional<V> find(const K& key) const {
+    std::uint64_t hash = detail::perfect_hash_key(key);
+    auto const& slot = slots[slot_of(hash, displacements[bucket_of(hash)])];
+    if (slot && slot->first == key) {
+      return slot->second;
+    }
+    return nullopt;
+  }
+
+  constexpr bool contains(const K& key) const {
+    return find(key).has_value();
+  }
+
+  static constexpr std::size_t size() noexcept {
+    return N;
+  }
+
+private:
+  static constexpr int slot_bits = std::countr_zero(slot_count);
+
+  static constexpr std::size_t bucket_of(std::uint64_t hash) noexcept {
+    return static_cast<std::size_t>(hash & (bucket_count - 1));
+  }
+
+  static constexpr std::size_t slot_of(std::uint64_t hash,
+                                       std::uint32_t displacement) noexcept {
+    return detail::displaced_slot(hash, displacement, slot_bits);
+  }
+
+  // Finds a displacement that sends the keys order[first, last) of one bucket
+  // to distinct free slots and stores them there
+  constexpr std::uint32_t place(const value_type (&entries)[N],
+                                const std::array<std::uint64_t, N>& hashes,
+                                const std::array<std::size_t, N>& order,
+                                std::size_t first, std::size_t last) {
+    constexpr std::uint32_t max_displacement = 1u << 20;
+    for (std::uint32_t d = 0; d < max_displacement; ++d) {
+      bool fits = true;
+      for (std::size_t i = first; i < last && fits; ++i) {
+        std::size_t slot = slot_of(hashes[order[i]], d);
+        fits = !slots[slot];
+        for (std::size_t j = first; j < i && fits; ++j) {
+          fits = slot_of(hashes[order[j]], d) != slot;
+        }
+      }
+      if (fits) {
+        for (std::size_t i = first; i < last; ++i) {
+          slots[slot_of(hashes[order[i]], d)] = entries[order[i]];
+        }
+        return d;
+      }
+    }
+    throw std::length_error("perfect_hash_map: no displacement found");
+  }
+
+  std::array<std::uint32_t, bucket_count> displacements{};
+  std::array<optional<value_type>, slot_count> slots{};
+};
+
+template <typename K, typename V, std::size_t N>
+constexpr perfect_hash_map<K, V, N>
+make_perfect_hash_map(const std::pair<K, V> (&entries)[N]) {
+  return perfect_hash_map<K, V, N>(entries);
+}
@@ -0,0 +1,108 @@
+#include "perfect_hash_map.h"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <random>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+// A table of 256 error codes to descriptors: lookups in a constexpr
+// perfect_hash_map against std::unordered_map, and the startup cost of
+// building the unordered_map (the constexpr table has none, it is in .rodata).
+
+namespace {
+struct descriptor {
+  std::uint32_t category;
+  std::uint32_t severity;
+};
+
+constexpr std::size_t code_count = 256;
+
+constexpr int code(std::size_t i) {
+  return static_cast<int>(i * 7919 + 13);
+}
+
+constexpr auto entries = [] {
+  std::array<std::pair<int, descriptor>, code_count> result{};
+  for (std::size_t i = 0; i < code_count; ++i) {
+    result[i] = {code(i), {static_cast<std::uint32_t>(i % 16),
+                           static_cast<std::uint32_t>(i % 3)}};
+  }
+  return result;
+}();
+
+constexpr auto perfect_codes = [] {
+  std::pair<int, descriptor> raw[code_count]{};
+  std::copy(entries.begin(), entries.end(), raw);
+  return perfect_hash_map<int, descriptor, code_count>(raw);
+}();
+
+std::unordered_map<int, descriptor> build_unordered_codes() {
+  return {entries.begin(), entries.end()};
+}
+
+// Every other query misses
+std::vector<int> make_queries() {
+  std::mt19937 rng(3);
+  std::vector<int> queries(4096);
+  for (auto& q : queries) {
+    std::size_t i = rng() % code_count;
+    q = rng() % 2 ? code(i) : code(i) + 1;
+  }
+  return queries;
+}
+} // namespace
+
+static void BM_lookup_perfect_hash_map(benchmark::State& state) {
+  auto queries = make_queries();
+  for (auto _ : state) {
+    std::uint32_t total = 0;
+    for (int q : queries) {
+      auto d = perfect_codes.find(q);
+      total += d ? d->severity : 0;
+    }
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * queries.size());
+}
+BENCHMARK(BM_lookup_perfect_hash_map);
+
+static void BM_lookup_unordered_map(benchmark::State& state) {
+  auto queries = make_queries();
+  auto codes = build_unordered_codes();
+  for (auto _ : state) {
+    std::uint32_t total = 0;
+    for (int q : queries) {
+      auto it = codes.find(q);
+      optional<descriptor> d;
+      if (it != codes.end()) {
+        d = it->second;
+      }
+      total += d ? d->severity : 0;
+    }
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * queries.size());
+}
+BENCHMARK(BM_lookup_unordered_map);
+
+// What a service pays at startup for each table it builds
+static void BM_startup_unordered_map(benchmark::State& state) {
+  for (auto _ : state) {
+    auto codes = build_unordered_codes();
+    benchmark::DoNotOptimize(codes);
+  }
+}
+BENCHMARK(BM_startup_unordered_map);
+
+// For reference: the same construction as perfect_codes, at run time
+static void BM_startup_perfect_hash_map_at_runtime(benchmark::State& state) {
+  std::pair<int, descriptor> raw[code_count]{};
+  std::copy(entries.begin(), entries.end(), raw);
+  for (auto _ : state) {
+    benchmark::DoNotOptimize(raw);
+    perfect_hash_map<int, descriptor, code_count> codes(raw);
+    benchmark::DoNotOptimize(codes);
+  }
+}
+BENCHMARK(BM_startup_perfect_hash_map_at_runtime);
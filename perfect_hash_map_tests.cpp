@@ -0,0 +1,84 @@
+#include "perfect_hash_map.h"
+#include "gtest/gtest.h"
+#include <array>
+#include <cstdint>
+#include <stdexcept>
+#include <string_view>
+
+namespace {
+struct descriptor {
+  std::string_view name;
+  int severity;
+
+  constexpr bool operator==(const descriptor&) const = default;
+};
+
+constexpr auto status_codes = make_perfect_hash_map<int, descriptor>({
+    {200, {"ok", 0}},
+    {301, {"moved permanently", 0}},
+    {404, {"not found", 1}},
+    {429, {"too many requests", 1}},
+    {500, {"internal error", 2}},
+    {503, {"unavailable", 2}},
+});
+
+constexpr auto units = make_perfect_hash_map<std::string_view, double>({
+    {"ns", 1e-9},
+    {"us", 1e-6},
+    {"ms", 1e-3},
+    {"s", 1.0},
+    {"min", 60.0},
+    {"h", 3600.0},
+});
+
+// Keys spread over the whole range, 1000 of them
+constexpr std::size_t many = 1000;
+
+constexpr std::uint64_t many_key(std::size_t i) {
+  return detail::mix_hash(i) >> 3;
+}
+
+constexpr auto many_keys = [] {
+  std::pair<std::uint64_t, std::size_t> entries[many]{};
+  for (std::size_t i = 0; i < many; ++i) {
+    entries[i] = {many_key(i), i};
+  }
+  return perfect_hash_map<std::uint64_t, std::size_t, many>(entries);
+}();
+} // namespace
+
+static_assert(status_codes.find(404) == optional<descriptor>({"not found", 1}));
+static_assert(!status_codes.find(418).has_value());
+static_assert(units.find("ms") == optional<double>(1e-3));
+static_assert(!units.contains("days"));
+static_assert(many_keys.find(many_key(many - 1)) ==
+              optional<std::size_t>(many - 1));
+
+TEST(perfect_hash_map_testing, finds_every_key) {
+  for (int code : {200, 301, 404, 429, 500, 503}) {
+    EXPECT_TRUE(status_codes.contains(code)) << code;
+  }
+  EXPECT_EQ("internal error", status_codes.find(500)->name);
+  EXPECT_EQ(6u, status_codes.size());
+  for (std::size_t i = 0; i < many; ++i) {
+    ASSERT_EQ(optional<std::size_t>(i), many_keys.find(many_key(i)));
+  }
+}
+
+TEST(perfect_hash_map_testing, misses) {
+  for (int code = 0; code < 1000; ++code) {
+    if (code != 200 && code != 301 && code != 404 && code != 429 &&
+        code != 500 && code != 503) {
+      EXPECT_FALSE(status_codes.find(code).has_value()) << code;
+    }
+  }
+  EXPECT_FALSE(units.find("").has_value());
+  EXPECT_FALSE(units.find("m").has_value());
+}
+
+TEST(perfect_hash_map_testing, runtime_construction) {
+  auto map = make_perfect_hash_map<int, int>({{1, 10}, {2, 20}, {3, 30}});
+  EXPECT_EQ(optional<int>(20), map.find(2));
+  EXPECT_THROW((make_perfect_hash_map<int, int>({{1, 10}, {1, 20}})),
+               std::invalid_argument);
+}
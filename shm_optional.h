@@ -0,0 +1,273 @@
+#pragma once
+
+#include "optional.h"
+#include "posix_error.h"
+
+#include <atomic>
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <new>
+#include <stdexcept>
+#include <string>
+#include <sys/mman.h>
+#include <thread>
+#include <type_traits>
+#include <unistd.h>
+#include <utility>
+
+// Types that may be placed in memory shared between processes: raw bytes that
+// mean the same in every address space. Pointers into a segment are mapped at
+// different addresses in different processes, so structs holding pointers
+// should specialize this to false (there is no way to detect them here).
+template <typename T>
+struct is_process_shareable
+    : std::bool_constant<std::is_trivially_copyable_v<T> &&
+                         !std::is_pointer_v<T> &&
+                         !std::is_member_pointer_v<T>> {};
+
+template <typename T>
+inline constexpr bool is_process_shareable_v = is_process_shareable<T>::value;
+
+/*******************************************************************************
+ *                           Process-shared optional                           *
+ *******************************************************************************/
+
+// Nullable T that lives in shared memory and is read and written by several
+// processes. The layout is fixed and does not depend on the process:
+//
+//   [0, 8)                         std::uint64_t state, native byte order
+//   [payload_offset, + sizeof(T))  payload bytes
+//
+// with payload_offset = max(8, alignof(T)). Bit 0 of `state` is set while a
+// write is in progress, bit 1 is the engaged flag and the bits above count the
+// completed writes.
+//
+// Writes take the write bit (so any number of writers may race) and publish
+// the new state with a release store. Readers follow the seqlock protocol:
+// they copy the payload between two acquire loads of `state` and retry if a
+// write overlapped, so `load()` never returns a torn value and never blocks
+// writers. A process that dies in the middle of a write leaves the write bit
+// set; the object is then unusable.
+template <typename T>
+class shm_optional {
+  static_assert(is_process_shareable_v<T>,
+                "shm_optional payloads must be plain bytes without pointers");
+  static_assert(std::atomic<std::uint64_t>::is_always_lock_free,
+                "a process-shared flag needs a lock-free atomic");
+
+  static constexpr std::uint64_t writing = 1;
+  static constexpr std::uint64_t engaged = 2;
+  static constexpr std::uint64_t version_step = 4;
+
+public:
+  static constexpr std::size_t payload_offset =
+      alignof(T) > sizeof(std::uint64_t) ? alignof(T) : sizeof(std::uint64_t);
+
+  shm_optional() noexcept = default;
+
+  // Lives at a fixed place in the segment
+  shm_optional(const shm_optional&) = delete;
+  shm_optional& operator=(const shm_optional&) = delete;
+
+  void store(const T& value) noexcept {
+    std::uint64_t old = lock();
+    std::memcpy(payload, &value, sizeof(T));
+    unlock(old, true);
+  }
+
+  void reset() noexcept {
+    std::uint64_t old = lock();
+    unlock(old, false);
+  }
+
+  // Consistent snapshot of the last completed write
+  optional<T> load() const noexcept {
+    for (;;) {
+      std::uint64_t before = state.load(std::memory_order_acquire);
+      if (before & writing) {
+        // The writer may be a preempted process, give it the CPU
+        std::this_thread::yield();
+        continue;
+      }
+      if (!(before & engaged)) {
+        return nullopt;
+      }
+      bytes snapshot;
+      std::memcpy(snapshot.data, payload, sizeof(T));
+      // Orders the payload reads before the second load of the state
+      std::atomic_thread_fence(std::memory_order_acquire);
+      if (state.load(std::memory_order_relaxed) == before) {
+        return std::bit_cast<T>(snapshot);
+      }
+    }
+  }
+
+  [[nodiscard]] bool has_value() const noexcept {
+    return (state.load(std::memory_order_acquire) & engaged) != 0;
+  }
+
+  // Number of completed writes, waiting for it to change is how a reader
+  // learns about a new value
+  std::uint64_t version() const noexcept {
+    return state.load(std::memory_order_acquire) / version_step;
+  }
+
+private:
+  struct bytes {
+    alignas(T) unsigned char data[sizeof(T)];
+  };
+
+  // Returns the state before the write bit was taken
+  std::uint64_t lock() noexcept {
+    std::uint64_t old = state.load(std::memory_order_relaxed);
+    for (;;) {
+      if (old & writing) {
+        std::this_thread::yield();
+        old = state.load(std::memory_order_relaxed);
+      } else if (state.compare_exchange_weak(old, old | writing,
+                                             std::memory_order_acquire,
+                                             std::memory_order_relaxed)) {
+        break;
+      }
+    }
+    // A reader that sees the new payload must also see the write bit
+    std::atomic_thread_fence(std::memory_order_release);
+    return old;
+  }
+
+  void unlock(std::uint64_t old, bool engaged_) noexcept {
+    std::uint64_t next = (old & ~(version_step - 1)) + version_step;
+    state.store(next | (engaged_ ? engaged : 0), std::memory_order_release);
+  }
+
+  std::atomic<std::uint64_t> state{0};
+  alignas(payload_offset) unsigned char payload[sizeof(T)];
+};
+
+/*******************************************************************************
+ *                               Shared segments                               *
+ *******************************************************************************/
+
+// A memfd-backed (Linux) shared memory segment with a bump arena for placing
+// shm_optionals and other process-shareable objects. The segment starts with
+// an `arena_header`, objects follow it and are never freed.
+//
+// The mapping is inherited by `fork` children at the same address. Unrelated
+// processes receive the fd (over a unix socket, or /proc/<pid>/fd/<fd>) and
+// `attach` it, getting a mapping at a different address: exchange objects by
+// their `offset_of` and resolve them with `at`.
+class shm_region {
+public:
+  struct arena_header {
+    std::atomic<std::uint64_t> used;
+    std::uint64_t capacity;
+  };
+
+  // A new zero-filled segment of `size` bytes, `name` only shows up in
+  // /proc/<pid>/fd
+  static shm_region create(const std::string& name, std::size_t size) {
+    if (size < sizeof(arena_header)) {
+      throw std::invalid_argument("shm_region: segment is too small");
+    }
+    int fd = ::memfd_create(name.c_str(), MFD_CLOEXEC);
+    if (fd < 0) {
+      detail::throw_errno("memfd_create " + name);
+    }
+    if (::ftruncate(fd, static_cast<off_t>(size)) != 0) {
+      ::close(fd);
+      detail::throw_errno("ftruncate " + name);
+    }
+    shm_region region(fd, size);
+    auto* header = new (region.mapping) arena_header{};
+    header->used.store(sizeof(arena_header), std::memory_order_relaxed);
+    header->capacity = size;
+    return region;
+  }
+
+  // Maps a segment made by `create` in another process, takes ownership of
+  // `fd`
+  static shm_region attach(int fd, std::size_t size) {
+    return shm_region(fd, size);
+  }
+
+  shm_region(shm_region&& other) noexcept
+      : fd{std::exchange(other.fd, -1)},
+        mapping{std::exchange(other.mapping, nullptr)},
+        mapped_size{std::exchange(other.mapped_size, 0)} {}
+
+  shm_region& operator=(shm_region&& other) noexcept {
+    shm_region tmp{std::move(other)};
+    std::swap(fd, tmp.fd);
+    std::swap(mapping, tmp.mapping);
+    std::swap(mapped_size, tmp.mapped_size);
+    return *this;
+  }
+
+  ~shm_region() {
+    if (mapping != nullptr) {
+      ::munmap(mapping, mapped_size);
+    }
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+
+  // Places a T in the arena. Objects are never destroyed, so T must be
+  // trivially destructible. Safe to call from several processes at once.
+  template <typename T, typename... Args>
+  T* construct(Args&&... args) {
+    static_assert(std::is_trivially_destructible_v<T>,
+                  "arena objects are never destroyed");
+    auto& used = header().used;
+    std::uint64_t begin = used.load(std::memory_order_relaxed);
+    std::uint64_t end;
+    do {
+      begin = (begin + alignof(T) - 1) / alignof(T) * alignof(T);
+      end = begin + sizeof(T);
+      if (end > header().capacity) {
+        throw std::bad_alloc();
+      }
+    } while (!used.compare_exchange_weak(begin, end,
+                                         std::memory_order_relaxed));
+    return new (mapping + begin) T(std::forward<Args>(args)...);
+  }
+
+  // Position-independent name of an object in the segment
+  std::size_t offset_of(const void* object) const noexcept {
+    return static_cast<std::size_t>(static_cast<const char*>(object) -
+                                    mapping);
+  }
+
+  template <typename T>
+  T* at(std::size_t offset) const noexcept {
+    return std::launder(reinterpret_cast<T*>(mapping + offset));
+  }
+
+  int native_handle() const noexcept {
+    return fd;
+  }
+
+  std::size_t size() const noexcept {
+    return mapped_size;
+  }
+
+private:
+  shm_region(int fd_, std::size_t size) : fd{fd_}, mapped_size{size} {
+    void* p = ::mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (p == MAP_FAILED) {
+      ::close(fd);
+      detail::throw_errno("mmap");
+    }
+    mapping = static_cast<char*>(p);
+  }
+
+  arena_header& header() const noexcept {
+    return *at<arena_header>(0);
+  }
+
+  int fd{-1};
+  char* mapping{nullptr};
+  std::size_t mapped_size{0};
+};
@@ -0,0 +1,108 @@
+#include "shm_optional.h"
+#include <benchmark/benchmark.h>
+#include <csignal>
+#include <cstdint>
+#include <sys/socket.h>
+#include <sys/wait.h>
+#include <thread>
+#include <unistd.h>
+
+// Round trip to an echo process: a 32-byte message published through a
+// shm_optional and answered through another one, against the same message
+// written to and read back from a socketpair. The shared memory side spins
+// (yielding) on `version()`.
+
+namespace {
+struct message {
+  std::uint64_t id;
+  std::uint64_t payload[3];
+};
+
+constexpr std::uint64_t stop = ~std::uint64_t{0};
+
+void wait_for_version(const shm_optional<message>& o, std::uint64_t seen) {
+  while (o.version() == seen) {
+    std::this_thread::yield();
+  }
+}
+
+bool read_fully(int fd, void* data, std::size_t size) {
+  auto bytes = static_cast<char*>(data);
+  while (size > 0) {
+    ssize_t n = ::read(fd, bytes, size);
+    if (n <= 0) {
+      return false;
+    }
+    bytes += n;
+    size -= static_cast<std::size_t>(n);
+  }
+  return true;
+}
+} // namespace
+
+static void BM_shm_optional_round_trip(benchmark::State& state) {
+  auto region = shm_region::create("bench", 4096);
+  auto* request = region.construct<shm_optional<message>>();
+  auto* reply = region.construct<shm_optional<message>>();
+
+  pid_t echo = ::fork();
+  if (echo == 0) {
+    for (std::uint64_t seen = 0;;) {
+      wait_for_version(*request, seen);
+      seen = request->version();
+      message m = *request->load();
+      if (m.id == stop) {
+        ::_exit(0);
+      }
+      reply->store(m);
+    }
+  }
+
+  message m{};
+  for (auto _ : state) {
+    std::uint64_t seen = reply->version();
+    request->store(m);
+    wait_for_version(*reply, seen);
+    m = *reply->load();
+    ++m.id;
+  }
+  request->store(message{stop, {}});
+  ::waitpid(echo, nullptr, 0);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_shm_optional_round_trip)->UseRealTime();
+
+static void BM_socketpair_round_trip(benchmark::State& state) {
+  int fds[2];
+  if (::socketpair(AF_UNIX, SOCK_STREAM, 0, fds) != 0) {
+    state.SkipWithError("socketpair failed");
+    return;
+  }
+
+  pid_t echo = ::fork();
+  if (echo == 0) {
+    ::close(fds[0]);
+    message m;
+    while (read_fully(fds[1], &m, sizeof(m))) {
+      if (::write(fds[1], &m, sizeof(m)) != sizeof(m)) {
+        break;
+      }
+    }
+    ::_exit(0);
+  }
+  ::close(fds[1]);
+
+  message m{};
+  for (auto _ : state) {
+    if (::write(fds[0], &m, sizeof(m)) != sizeof(m) ||
+        !read_fully(fds[0], &m, sizeof(m))) {
+      state.SkipWithError("echo process failed");
+      break;
+    }
+    ++m.id;
+  }
+  ::close(fds[0]);
+  ::waitpid(echo, nullptr, 0);
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_socketpair_round_trip)->UseRealTime();
@@ -0,0 +1,155 @@
+#include "shm_optional.h"
+#include "gtest/gtest.h"
+#include <cstddef>
+#include <cstdint>
+#include <sys/wait.h>
+#include <unistd.h>
+
+namespace {
+struct quote {
+  std::uint64_t sequence;
+  double bid;
+  double ask;
+  // Always ~sequence, a torn read would break it
+  std::uint64_t check;
+};
+
+quote make_quote(std::uint64_t i) {
+  return {i, static_cast<double>(i), static_cast<double>(i) + 0.5, ~i};
+}
+
+struct pointers {
+  int* p;
+};
+
+struct page {
+  char bytes[4096];
+};
+
+// Runs `child` in a forked process, returns its exit code
+template <typename F>
+int run_child(F child) {
+  pid_t pid = ::fork();
+  if (pid == 0) {
+    ::_exit(child());
+  }
+  int status = 0;
+  ::waitpid(pid, &status, 0);
+  return WIFEXITED(status) ? WEXITSTATUS(status) : -1;
+}
+} // namespace
+
+template <>
+struct is_process_shareable<pointers> : std::false_type {};
+
+static_assert(is_process_shareable_v<quote>);
+static_assert(!is_process_shareable_v<int*>);
+static_assert(!is_process_shareable_v<pointers>);
+static_assert(std::is_trivially_destructible_v<shm_optional<quote>>);
+
+TEST(shm_optional_testing, layout) {
+  EXPECT_EQ(8u, shm_optional<char>::payload_offset);
+  EXPECT_EQ(8u, shm_optional<quote>::payload_offset);
+  EXPECT_EQ(16u, shm_optional<long double>::payload_offset);
+  EXPECT_EQ(8 + sizeof(quote), sizeof(shm_optional<quote>));
+
+  shm_optional<std::uint32_t> o;
+  o.store(0xdeadbeef);
+  auto bytes = reinterpret_cast<const unsigned char*>(&o);
+  std::uint64_t state;
+  std::uint32_t payload;
+  std::memcpy(&state, bytes, sizeof(state));
+  std::memcpy(&payload, bytes + shm_optional<std::uint32_t>::payload_offset,
+              sizeof(payload));
+  // One completed write, engaged
+  EXPECT_EQ(4u | 2u, state);
+  EXPECT_EQ(0xdeadbeef, payload);
+}
+
+TEST(shm_optional_testing, store_load_reset) {
+  shm_optional<quote> o;
+  EXPECT_FALSE(o.has_value());
+  EXPECT_FALSE(o.load().has_value());
+  EXPECT_EQ(0u, o.version());
+
+  o.store(make_quote(7));
+  ASSERT_TRUE(o.has_value());
+  EXPECT_EQ(7u, o.load()->sequence);
+  EXPECT_EQ(1u, o.version());
+
+  o.reset();
+  EXPECT_FALSE(o.load().has_value());
+  EXPECT_EQ(2u, o.version());
+}
+
+TEST(shm_optional_testing, region_arena) {
+  auto region = shm_region::create("arena", 4096);
+  auto* a = region.construct<shm_optional<char>>();
+  auto* b = region.construct<shm_optional<quote>>();
+  EXPECT_EQ(0u, reinterpret_cast<std::uintptr_t>(b) % alignof(decltype(*b)));
+  EXPECT_LT(region.offset_of(a), region.offset_of(b));
+  EXPECT_EQ(b, region.at<shm_optional<quote>>(region.offset_of(b)));
+  EXPECT_THROW(region.construct<page>(), std::bad_alloc);
+}
+
+TEST(shm_optional_testing, attach_at_other_address) {
+  auto region = shm_region::create("attach", 4096);
+  auto* o = region.construct<shm_optional<quote>>();
+  o->store(make_quote(1));
+
+  auto view = shm_region::attach(::dup(region.native_handle()), region.size());
+  auto* same = view.at<shm_optional<quote>>(region.offset_of(o));
+  EXPECT_NE(static_cast<void*>(o), static_cast<void*>(same));
+  EXPECT_EQ(1u, same->load()->sequence);
+  same->store(make_quote(2));
+  EXPECT_EQ(2u, o->load()->sequence);
+}
+
+TEST(shm_optional_testing, handoff_between_processes) {
+  auto region = shm_region::create("handoff", 4096);
+  auto* request = region.construct<shm_optional<quote>>();
+  auto* reply = region.construct<shm_optional<quote>>();
+  request->store(make_quote(41));
+
+  int code = run_child([&] {
+    auto q = request->load();
+    if (!q || q->sequence != 41) {
+      return 1;
+    }
+    q->sequence += 1;
+    reply->store(*q);
+    request->reset();
+    return 0;
+  });
+  ASSERT_EQ(0, code);
+  EXPECT_FALSE(request->has_value());
+  ASSERT_TRUE(reply->has_value());
+  EXPECT_EQ(42u, reply->load()->sequence);
+}
+
+TEST(shm_optional_testing, no_torn_reads) {
+  auto region = shm_region::create("torn", 4096);
+  auto* o = region.construct<shm_optional<quote>>();
+  constexpr std::uint64_t writes = 200'000;
+  o->store(make_quote(0));
+
+  pid_t writer = ::fork();
+  if (writer == 0) {
+    for (std::uint64_t i = 1; i <= writes; ++i) {
+      o->store(make_quote(i));
+    }
+    ::_exit(0);
+  }
+  std::uint64_t last = 0;
+  bool consistent = true;
+  while (last < writes && consistent) {
+    quote q = *o->load();
+    consistent = q.check == ~q.sequence && q.bid + 0.5 == q.ask &&
+                 q.sequence >= last;
+    last = q.sequence;
+  }
+  int status = 0;
+  ::waitpid(writer, &status, 0);
+  EXPECT_TRUE(consistent);
+  EXPECT_EQ(writes + 1, o->version());
+}
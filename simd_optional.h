@@ -0,0 +1,454 @@
+#pragma once
+
+#include "optional.h"
+
+#include <array>
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <functional>
+#include <span>
+#include <type_traits>
+#include <utility>
+
+#if __has_include(<experimental/simd>)
+#include <experimental/simd>
+#endif
+
+namespace detail {
+/*******************************************************************************
+ *                                    Lanes                                    *
+ *******************************************************************************/
+
+// Fallback for targets without std::experimental::simd: the subset of its
+// interface used by `simd_optional`, as element-wise loops over an array that
+// the compiler is free to vectorize
+template <typename T, std::size_t N>
+struct scalar_lanes {
+  std::array<T, N> lane{};
+
+  constexpr scalar_lanes() = default;
+
+  // Broadcast
+  constexpr scalar_lanes(T value) noexcept {
+    lane.fill(value);
+  }
+
+  // lane[i] = gen(i)
+  template <typename G, typename = std::enable_if_t<
+                            std::is_invocable_r_v<T, G&, std::size_t>>>
+  constexpr explicit scalar_lanes(G&& gen) {
+    for (std::size_t i = 0; i < N; ++i) {
+      lane[i] = gen(i);
+    }
+  }
+
+  constexpr T& operator[](std::size_t i) noexcept {
+    return lane[i];
+  }
+
+  constexpr T operator[](std::size_t i) const noexcept {
+    return lane[i];
+  }
+
+  template <typename F>
+  static constexpr scalar_lanes apply(F f) {
+    scalar_lanes result;
+    for (std::size_t i = 0; i < N; ++i) {
+      result.lane[i] = static_cast<T>(f(i));
+    }
+    return result;
+  }
+
+  template <typename Op>
+  static constexpr scalar_lanes zip(const scalar_lanes& a,
+                                    const scalar_lanes& b, Op op) {
+    return apply([&](std::size_t i) { return op(a.lane[i], b.lane[i]); });
+  }
+
+  template <typename Op>
+  static constexpr scalar_lanes<bool, N> test(const scalar_lanes& a,
+                                              const scalar_lanes& b, Op op) {
+    return scalar_lanes<bool, N>::apply(
+        [&](std::size_t i) { return op(a.lane[i], b.lane[i]); });
+  }
+
+  friend constexpr scalar_lanes operator+(const scalar_lanes& a,
+                                          const scalar_lanes& b) {
+    return zip(a, b, std::plus<>{});
+  }
+
+  friend constexpr scalar_lanes operator-(const scalar_lanes& a,
+                                          const scalar_lanes& b) {
+    return zip(a, b, std::minus<>{});
+  }
+
+  friend constexpr scalar_lanes operator*(const scalar_lanes& a,
+                                          const scalar_lanes& b) {
+    return zip(a, b, std::multiplies<>{});
+  }
+
+  friend constexpr scalar_lanes operator/(const scalar_lanes& a,
+                                          const scalar_lanes& b) {
+    return zip(a, b, std::divides<>{});
+  }
+
+  friend constexpr scalar_lanes operator&&(const scalar_lanes& a,
+                                           const scalar_lanes& b) {
+    return zip(a, b, std::logical_and<>{});
+  }
+
+  friend constexpr scalar_lanes operator||(const scalar_lanes& a,
+                                           const scalar_lanes& b) {
+    return zip(a, b, std::logical_or<>{});
+  }
+
+  friend constexpr scalar_lanes<bool, N> operator==(const scalar_lanes& a,
+                                                    const scalar_lanes& b) {
+    return test(a, b, std::equal_to<>{});
+  }
+
+  friend constexpr scalar_lanes<bool, N> operator!=(const scalar_lanes& a,
+                                                    const scalar_lanes& b) {
+    return test(a, b, std::not_equal_to<>{});
+  }
+
+  friend constexpr scalar_lanes<bool, N> operator<(const scalar_lanes& a,
+                                                   const scalar_lanes& b) {
+    return test(a, b, std::less<>{});
+  }
+
+  friend constexpr scalar_lanes<bool, N> operator<=(const scalar_lanes& a,
+                                                    const scalar_lanes& b) {
+    return test(a, b, std::less_equal<>{});
+  }
+
+  friend constexpr scalar_lanes<bool, N> operator>(const scalar_lanes& a,
+                                                   const scalar_lanes& b) {
+    return test(a, b, std::greater<>{});
+  }
+
+  friend constexpr scalar_lanes<bool, N> operator>=(const scalar_lanes& a,
+                                                    const scalar_lanes& b) {
+    return test(a, b, std::greater_equal<>{});
+  }
+
+  friend constexpr scalar_lanes operator-(const scalar_lanes& a) {
+    return apply([&](std::size_t i) { return -a.lane[i]; });
+  }
+
+  friend constexpr scalar_lanes operator!(const scalar_lanes& a) {
+    return apply([&](std::size_t i) { return !a.lane[i]; });
+  }
+};
+
+// mask ? a : b, lane by lane
+template <typename T, std::size_t N>
+constexpr scalar_lanes<T, N> lane_select(const scalar_lanes<bool, N>& mask,
+                                         const scalar_lanes<T, N>& a,
+                                         const scalar_lanes<T, N>& b) {
+  return scalar_lanes<T, N>::apply(
+      [&](std::size_t i) { return mask.lane[i] ? a.lane[i] : b.lane[i]; });
+}
+
+template <typename T, std::size_t N>
+void lane_load(scalar_lanes<T, N>& lanes, const T* from) {
+  for (std::size_t i = 0; i < N; ++i) {
+    lanes.lane[i] = from[i];
+  }
+}
+
+template <typename T, std::size_t N>
+void lane_store(const scalar_lanes<T, N>& lanes, T* to) {
+  for (std::size_t i = 0; i < N; ++i) {
+    to[i] = lanes.lane[i];
+  }
+}
+
+template <std::size_t N>
+constexpr std::size_t lane_count(const scalar_lanes<bool, N>& mask) {
+  std::size_t count = 0;
+  for (std::size_t i = 0; i < N; ++i) {
+    count += mask.lane[i];
+  }
+  return count;
+}
+
+// Lane i is nonzero iff bit i of `bits` is set. Floating point lanes test
+// 32-bit pieces of `bits`: 32-bit integers convert to floating point lanes in
+// one instruction, 64-bit ones do not before AVX-512.
+template <typename Values, typename T>
+Values bit_lanes(std::uint64_t bits) {
+  return Values([&](auto i) {
+    if constexpr (std::is_integral_v<T>) {
+      return T((bits >> i) & 1);
+    } else {
+      auto piece = static_cast<std::uint32_t>(bits >> (i / 32 * 32));
+      auto bit = piece & (std::uint32_t{1} << i % 32);
+      return T(static_cast<std::int32_t>(bit));
+    }
+  });
+}
+
+template <typename T, std::size_t N, bool use_std_simd>
+struct simd_types {
+  using values = scalar_lanes<T, N>;
+  using mask = scalar_lanes<bool, N>;
+};
+
+#if __has_include(<experimental/simd>)
+inline constexpr bool has_std_simd = true;
+
+template <typename T, std::size_t N>
+struct simd_types<T, N, true> {
+  using values = std::experimental::fixed_size_simd<T, N>;
+  using mask = std::experimental::fixed_size_simd_mask<T, N>;
+};
+
+template <typename T, typename Abi>
+std::experimental::simd<T, Abi>
+lane_select(const std::experimental::simd_mask<T, Abi>& mask,
+            const std::experimental::simd<T, Abi>& a,
+            std::experimental::simd<T, Abi> b) {
+  std::experimental::where(mask, b) = a;
+  return b;
+}
+
+template <typename T, typename Abi>
+void lane_load(std::experimental::simd<T, Abi>& lanes, const T* from) {
+  lanes.copy_from(from, std::experimental::element_aligned);
+}
+
+template <typename T, typename Abi>
+void lane_store(const std::experimental::simd<T, Abi>& lanes, T* to) {
+  lanes.copy_to(to, std::experimental::element_aligned);
+}
+
+template <typename T, typename Abi>
+std::size_t lane_count(const std::experimental::simd_mask<T, Abi>& mask) {
+  return static_cast<std::size_t>(std::experimental::popcount(mask));
+}
+#else
+inline constexpr bool has_std_simd = false;
+#endif
+} // namespace detail
+
+/*******************************************************************************
+ *                                Simd optional                                *
+ *******************************************************************************/
+
+// Lane-wise result of a `simd_optional` comparison. A lane is null when either
+// operand lane is null; `value` is false in null lanes.
+template <typename Mask>
+struct simd_optional_mask {
+  Mask value;
+  Mask engaged;
+
+  // Resolves null lanes to `fallback`
+  Mask value_or(bool fallback) const {
+    return value || (!engaged && Mask(fallback));
+  }
+};
+
+// N nullable numbers: a register of values and a lane mask of engaged lanes.
+// Every operation works on whole registers and propagates nulls through the
+// mask, there is no branch on lane state. Null lanes always hold T{}, so the
+// values can be stored as is into zero-filled nullable columns.
+template <typename T, std::size_t N, bool use_std_simd = detail::has_std_simd>
+class simd_optional {
+  static_assert(std::is_arithmetic_v<T> && !std::is_same_v<T, bool>,
+                "simd_optional holds integers or floating point values");
+
+public:
+  using value_type = T;
+  using values_type = typename detail::simd_types<T, N, use_std_simd>::values;
+  using mask_type = typename detail::simd_types<T, N, use_std_simd>::mask;
+  using comparison_type = simd_optional_mask<mask_type>;
+
+  // All lanes null
+  simd_optional() noexcept : vals(T{}), engaged(false) {}
+
+  simd_optional(nullopt_t) noexcept : simd_optional() {}
+
+  // All lanes engaged with `value`
+  simd_optional(T value) noexcept : vals(value), engaged(true) {}
+
+  simd_optional(const values_type& values, const mask_type& mask)
+      : vals(detail::lane_select(mask, values, values_type(T{}))),
+        engaged(mask) {}
+
+  static constexpr std::size_t size() noexcept {
+    return N;
+  }
+
+  const values_type& values() const noexcept {
+    return vals;
+  }
+
+  const mask_type& mask() const noexcept {
+    return engaged;
+  }
+
+  optional<T> operator[](std::size_t i) const {
+    assert(i < N);
+    return engaged[i] ? optional<T>(T(vals[i])) : optional<T>();
+  }
+
+  std::size_t count_engaged() const noexcept {
+    return detail::lane_count(engaged);
+  }
+
+  values_type value_or(const values_type& fallback) const {
+    return detail::lane_select(engaged, vals, fallback);
+  }
+
+  values_type value_or(T fallback) const {
+    return value_or(values_type(fallback));
+  }
+
+  /*****************************************************************************
+   *                            Loads and stores                               *
+   *****************************************************************************/
+
+  // Reads rows[0, N)
+  static simd_optional load(std::span<const optional<T>> rows) {
+    assert(rows.size() >= N);
+    values_type values([&](auto i) { return rows[i] ? *rows[i] : T{}; });
+    values_type flags([&](auto i) { return T(rows[i] ? 1 : 0); });
+    return {values, flags != values_type(T{})};
+  }
+
+  void store(std::span<optional<T>> rows) const {
+    assert(rows.size() >= N);
+    for (std::size_t i = 0; i < N; ++i) {
+      rows[i] = (*this)[i];
+    }
+  }
+
+  // Reads rows [first, first + N) of a column laid out as a value array and a
+  // validity bitmap, bit `row % 64` of word `row / 64` (see `column_view`)
+  static simd_optional load(const T* values, const std::uint64_t* validity,
+                            std::size_t first) {
+    static_assert(N <= 64, "a load covers at most two bitmap words");
+    std::size_t shift = first % 64;
+    std::uint64_t bits = validity[first / 64] >> shift;
+    if (shift + N > 64) {
+      bits |= validity[first / 64 + 1] << (64 - shift);
+    }
+    values_type lanes;
+    detail::lane_load(lanes, values + first);
+    return {lanes, detail::bit_lanes<values_type, T>(bits) != values_type(T{})};
+  }
+
+  // Writes rows [first, first + N); null rows get a zero value slot
+  void store(T* values, std::uint64_t* validity, std::size_t first) const {
+    static_assert(N <= 64, "a store covers at most two bitmap words");
+    std::uint64_t bits = 0;
+    for (std::size_t i = 0; i < N; ++i) {
+      bits |= std::uint64_t{engaged[i]} << i;
+    }
+    constexpr std::uint64_t lanes = N == 64 ? ~std::uint64_t{0}
+                                            : (std::uint64_t{1} << N) - 1;
+    std::size_t shift = first % 64;
+    std::uint64_t& low = validity[first / 64];
+    low = (low & ~(lanes << shift)) | (bits << shift);
+    if (shift + N > 64) {
+      std::uint64_t& high = validity[first / 64 + 1];
+      high = (high & ~(lanes >> (64 - shift))) | (bits >> (64 - shift));
+    }
+    detail::lane_store(vals, values + first);
+  }
+
+  /*****************************************************************************
+   *                         Null-propagating operators                        *
+   *****************************************************************************/
+
+  friend simd_optional operator+(const simd_optional& a,
+                                 const simd_optional& b) {
+    return {a.vals + b.vals, a.engaged && b.engaged};
+  }
+
+  friend simd_optional operator-(const simd_optional& a,
+                                 const simd_optional& b) {
+    return {a.vals - b.vals, a.engaged && b.engaged};
+  }
+
+  friend simd_optional operator*(const simd_optional& a,
+                                 const simd_optional& b) {
+    return {a.vals * b.vals, a.engaged && b.engaged};
+  }
+
+  // Null lanes of `b` hold zero; for integers they divide by one instead so
+  // that a null lane never traps
+  friend simd_optional operator/(const simd_optional& a,
+                                 const simd_optional& b) {
+    if constexpr (std::is_integral_v<T>) {
+      values_type divisor =
+          detail::lane_select(b.engaged, b.vals, values_type(T{1}));
+      return {a.vals / divisor, a.engaged && b.engaged};
+    } else {
+      return {a.vals / b.vals, a.engaged && b.engaged};
+    }
+  }
+
+  friend simd_optional operator-(const simd_optional& a) {
+    return {-a.vals, a.engaged};
+  }
+
+  simd_optional& operator+=(const simd_optional& other) {
+    return *this = *this + other;
+  }
+
+  simd_optional& operator-=(const simd_optional& other) {
+    return *this = *this - other;
+  }
+
+  simd_optional& operator*=(const simd_optional& other) {
+    return *this = *this * other;
+  }
+
+  simd_optional& operator/=(const simd_optional& other) {
+    return *this = *this / other;
+  }
+
+  friend comparison_type operator==(const simd_optional& a,
+                                    const simd_optional& b) {
+    return compare(a, b, std::equal_to<>{});
+  }
+
+  friend comparison_type operator!=(const simd_optional& a,
+                                    const simd_optional& b) {
+    return compare(a, b, std::not_equal_to<>{});
+  }
+
+  friend comparison_type operator<(const simd_optional& a,
+                                   const simd_optional& b) {
+    return compare(a, b, std::less<>{});
+  }
+
+  friend comparison_type operator<=(const simd_optional& a,
+                                    const simd_optional& b) {
+    return compare(a, b, std::less_equal<>{});
+  }
+
+  friend comparison_type operator>(const simd_optional& a,
+                                   const simd_optional& b) {
+    return compare(a, b, std::greater<>{});
+  }
+
+  friend comparison_type operator>=(const simd_optional& a,
+                                    const simd_optional& b) {
+    return compare(a, b, std::greater_equal<>{});
+  }
+
+private:
+  template <typename Op>
+  static comparison_type compare(const simd_optional& a,
+                                 const simd_optional& b, Op op) {
+    mask_type both = a.engaged && b.engaged;
+    return {op(a.vals, b.vals) && both, both};
+  }
+
+  values_type vals;
+  mask_type engaged;
+};
@@ -0,0 +1,126 @@
+#include "simd_optional.h"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <random>
+#include <vector>
+
+// Nullable arithmetic `c = a * b + a` and a null-skipping sum over 64k rows:
+// one `optional<double>` at a time against `simd_optional` registers, loaded
+// from spans of optionals and from bitmap-plus-values columns.
+
+namespace {
+constexpr std::size_t rows = 1 << 16;
+constexpr std::size_t lanes = 8;
+using simd_double = simd_optional<double, lanes>;
+
+struct nullable_columns {
+  nullable_columns() : a(rows), b(rows), c(rows) {
+    std::mt19937_64 rng(42);
+    for (std::size_t i = 0; i < rows; ++i) {
+      if (rng() % 10 != 0) {
+        a[i] = static_cast<double>(i);
+      }
+      if (rng() % 10 != 0) {
+        b[i] = 0.5;
+      }
+    }
+  }
+
+  std::vector<optional<double>> a, b, c;
+};
+
+struct bitmap_column {
+  explicit bitmap_column(const std::vector<optional<double>>& rows_)
+      : values(rows_.size()), validity((rows_.size() + 63) / 64) {
+    for (std::size_t i = 0; i < rows_.size(); ++i) {
+      if (rows_[i]) {
+        values[i] = *rows_[i];
+        validity[i / 64] |= std::uint64_t{1} << (i % 64);
+      }
+    }
+  }
+
+  std::vector<double> values;
+  std::vector<std::uint64_t> validity;
+};
+} // namespace
+
+static void BM_multiply_add_scalar(benchmark::State& state) {
+  nullable_columns data;
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < rows; ++i) {
+      if (data.a[i] && data.b[i]) {
+        data.c[i] = *data.a[i] * *data.b[i] + *data.a[i];
+      } else {
+        data.c[i] = nullopt;
+      }
+    }
+    benchmark::DoNotOptimize(data.c.data());
+  }
+  state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK(BM_multiply_add_scalar);
+
+static void BM_multiply_add_simd(benchmark::State& state) {
+  nullable_columns data;
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < rows; i += lanes) {
+      auto a = simd_double::load(std::span(data.a).subspan(i, lanes));
+      auto b = simd_double::load(std::span(data.b).subspan(i, lanes));
+      (a * b + a).store(std::span(data.c).subspan(i, lanes));
+    }
+    benchmark::DoNotOptimize(data.c.data());
+  }
+  state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK(BM_multiply_add_simd);
+
+static void BM_multiply_add_simd_bitmap(benchmark::State& state) {
+  nullable_columns data;
+  bitmap_column a_column(data.a), b_column(data.b), c_column(data.c);
+  for (auto _ : state) {
+    for (std::size_t i = 0; i < rows; i += lanes) {
+      auto a = simd_double::load(a_column.values.data(),
+                                 a_column.validity.data(), i);
+      auto b = simd_double::load(b_column.values.data(),
+                                 b_column.validity.data(), i);
+      (a * b + a).store(c_column.values.data(), c_column.validity.data(), i);
+    }
+    benchmark::DoNotOptimize(c_column.values.data());
+  }
+  state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK(BM_multiply_add_simd_bitmap);
+
+static void BM_sum_scalar(benchmark::State& state) {
+  nullable_columns data;
+  for (auto _ : state) {
+    double sum = 0;
+    for (auto const& row : data.a) {
+      sum += row ? *row : 0.0;
+    }
+    benchmark::DoNotOptimize(sum);
+  }
+  state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK(BM_sum_scalar);
+
+static void BM_sum_simd_bitmap(benchmark::State& state) {
+  nullable_columns data;
+  bitmap_column column(data.a);
+  for (auto _ : state) {
+    simd_double::values_type sum(0.0);
+    for (std::size_t i = 0; i < rows; i += lanes) {
+      auto row = simd_double::load(column.values.data(),
+                                   column.validity.data(), i);
+      sum = sum + row.value_or(0.0);
+    }
+    double total = 0;
+    for (std::size_t i = 0; i < lanes; ++i) {
+      total += sum[i];
+    }
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * rows);
+}
+BENCHMARK(BM_sum_simd_bitmap);
@@ -0,0 +1,174 @@
+#include "simd_optional.h"
+#include "gtest/gtest.h"
+#include <cstdint>
+#include <vector>
+
+namespace {
+template <typename Simd>
+class simd_optional_testing : public ::testing::Test {
+protected:
+  using T = typename Simd::value_type;
+  static constexpr std::size_t N = Simd::size();
+
+  // 1, null, 3, 4, null, 6, ...
+  std::vector<optional<T>> left() const {
+    std::vector<optional<T>> rows(N);
+    for (std::size_t i = 0; i < N; ++i) {
+      if (i % 3 != 1) {
+        rows[i] = T(i + 1);
+      }
+    }
+    return rows;
+  }
+
+  // 2, 2, null, 2, 2, 2, null, ...
+  std::vector<optional<T>> right() const {
+    std::vector<optional<T>> rows(N);
+    for (std::size_t i = 0; i < N; ++i) {
+      if (i % 4 != 2) {
+        rows[i] = T(2);
+      }
+    }
+    return rows;
+  }
+
+  // Checks every lane of `result` against `op` applied to scalar optionals
+  template <typename Op>
+  void expect_lanes(const Simd& result, Op op) const {
+    auto a = left();
+    auto b = right();
+    for (std::size_t i = 0; i < N; ++i) {
+      if (a[i] && b[i]) {
+        ASSERT_TRUE(static_cast<bool>(result[i])) << "lane " << i;
+        EXPECT_EQ(op(*a[i], *b[i]), *result[i]) << "lane " << i;
+      } else {
+        EXPECT_FALSE(static_cast<bool>(result[i])) << "lane " << i;
+        EXPECT_EQ(T{}, result.values()[i]) << "lane " << i;
+      }
+    }
+  }
+};
+
+// The `true` variants fall back to scalar lanes without <experimental/simd>
+using simd_optional_types =
+    ::testing::Types<simd_optional<int, 8, false>, simd_optional<int, 8, true>,
+                     simd_optional<double, 4, false>,
+                     simd_optional<double, 4, true>,
+                     simd_optional<std::int64_t, 16, true>>;
+} // namespace
+
+TYPED_TEST_SUITE(simd_optional_testing, simd_optional_types);
+
+TYPED_TEST(simd_optional_testing, default_and_broadcast) {
+  using T = typename TestFixture::T;
+  TypeParam empty, nulls(nullopt), fives(T(5));
+  EXPECT_EQ(0u, empty.count_engaged());
+  EXPECT_EQ(0u, nulls.count_engaged());
+  EXPECT_EQ(TestFixture::N, fives.count_engaged());
+  EXPECT_EQ(T(5), *fives[TestFixture::N - 1]);
+}
+
+TYPED_TEST(simd_optional_testing, load_store_optionals) {
+  auto rows = this->left();
+  auto a = TypeParam::load(rows);
+  for (std::size_t i = 0; i < TestFixture::N; ++i) {
+    EXPECT_EQ(rows[i], a[i]);
+  }
+  std::vector<optional<typename TestFixture::T>> out(TestFixture::N);
+  a.store(out);
+  EXPECT_EQ(rows, out);
+}
+
+TYPED_TEST(simd_optional_testing, arithmetic_propagates_nulls) {
+  auto a = TypeParam::load(this->left());
+  auto b = TypeParam::load(this->right());
+  this->expect_lanes(a + b, [](auto x, auto y) { return x + y; });
+  this->expect_lanes(a - b, [](auto x, auto y) { return x - y; });
+  this->expect_lanes(a * b, [](auto x, auto y) { return x * y; });
+  this->expect_lanes(a / b, [](auto x, auto y) { return x / y; });
+
+  a *= b;
+  this->expect_lanes(a, [](auto x, auto y) { return x * y; });
+}
+
+TYPED_TEST(simd_optional_testing, arithmetic_with_scalar) {
+  using T = typename TestFixture::T;
+  auto a = TypeParam::load(this->left());
+  auto doubled = a * T(2);
+  auto negated = -a;
+  for (std::size_t i = 0; i < TestFixture::N; ++i) {
+    if (a[i]) {
+      EXPECT_EQ(*a[i] * 2, *doubled[i]);
+      EXPECT_EQ(-*a[i], *negated[i]);
+    } else {
+      EXPECT_FALSE(static_cast<bool>(doubled[i]));
+      EXPECT_FALSE(static_cast<bool>(negated[i]));
+    }
+  }
+}
+
+TYPED_TEST(simd_optional_testing, division_by_null_lane) {
+  using T = typename TestFixture::T;
+  // Null lanes of the divisor hold zero
+  auto a = TypeParam(T(10));
+  auto b = TypeParam::load(this->right());
+  auto c = a / b;
+  EXPECT_EQ(b.count_engaged(), c.count_engaged());
+}
+
+TYPED_TEST(simd_optional_testing, comparisons) {
+  auto a = TypeParam::load(this->left());
+  auto b = TypeParam::load(this->right());
+  auto less = a < b;
+  auto equal = a == b;
+  auto rows_a = this->left();
+  auto rows_b = this->right();
+  auto less_or_true = less.value_or(true);
+  auto equal_or_false = equal.value_or(false);
+  for (std::size_t i = 0; i < TestFixture::N; ++i) {
+    bool both = rows_a[i] && rows_b[i];
+    EXPECT_EQ(both, static_cast<bool>(less.engaged[i])) << "lane " << i;
+    EXPECT_EQ(both && *rows_a[i] < *rows_b[i],
+              static_cast<bool>(less.value[i]));
+    EXPECT_EQ(!both || *rows_a[i] < *rows_b[i],
+              static_cast<bool>(less_or_true[i]));
+    EXPECT_EQ(both && *rows_a[i] == *rows_b[i],
+              static_cast<bool>(equal_or_false[i]));
+  }
+}
+
+TYPED_TEST(simd_optional_testing, value_or) {
+  using T = typename TestFixture::T;
+  auto a = TypeParam::load(this->left());
+  auto values = a.value_or(T(-1));
+  auto rows = this->left();
+  for (std::size_t i = 0; i < TestFixture::N; ++i) {
+    EXPECT_EQ(rows[i] ? *rows[i] : T(-1), values[i]);
+  }
+}
+
+TYPED_TEST(simd_optional_testing, bitmap_round_trip) {
+  using T = typename TestFixture::T;
+  constexpr std::size_t N = TestFixture::N;
+  // Starts close to the end of a bitmap word to cross into the next one
+  constexpr std::size_t first = 60;
+  std::vector<T> values(first + N, T(7));
+  std::vector<std::uint64_t> validity(2, ~std::uint64_t{0});
+
+  auto a = TypeParam::load(this->left());
+  a.store(values.data(), validity.data(), first);
+  auto rows = this->left();
+  for (std::size_t i = 0; i < N; ++i) {
+    std::size_t row = first + i;
+    EXPECT_EQ(static_cast<bool>(rows[i]),
+              static_cast<bool>((validity[row / 64] >> (row % 64)) & 1));
+    EXPECT_EQ(rows[i] ? *rows[i] : T{}, values[row]);
+  }
+  EXPECT_EQ(T(7), values[first - 1]);
+  EXPECT_TRUE((validity[0] >> (first - 1)) & 1);
+
+  auto b = TypeParam::load(values.data(), validity.data(), first);
+  for (std::size_t i = 0; i < N; ++i) {
+    EXPECT_EQ(rows[i], b[i]);
+  }
+}
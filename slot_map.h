@@ -0,0 +1,425 @@
+#pragma once
+
+#include <cassert>
+#include <compare>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <new>
+#include <stdexcept>
+#include <type_traits>
+#include <utility>
+#include <vector>
+
+struct slot_handle {
+  std::uint32_t index;
+  std::uint32_t generation;
+
+  friend constexpr bool operator==(slot_handle a, slot_handle b) noexcept {
+    return a.index == b.index && a.generation == b.generation;
+  }
+
+  friend constexpr bool operator!=(slot_handle a, slot_handle b) noexcept {
+    return !(a == b);
+  }
+};
+
+namespace detail {
+/*******************************************************************************
+ *                                  Map slots                                  *
+ *******************************************************************************/
+
+// Same idea as `storage_base`, except that the engaged flag is the parity of
+// the generation (odd = live) and a disengaged slot reuses the payload bytes
+// as the link of the free list.
+template <typename T, bool trivial = std::is_trivially_destructible_v<T>>
+union slot_payload {
+  std::uint32_t next_free;
+  T value;
+
+  constexpr slot_payload() noexcept : next_free{0} {}
+  ~slot_payload() {}
+};
+
+template <typename T>
+union slot_payload<T, true> {
+  std::uint32_t next_free;
+  T value;
+
+  constexpr slot_payload() noexcept : next_free{0} {}
+  // No user defined destructor => trivial
+};
+
+template <typename T>
+struct map_slot {
+  std::uint32_t generation{0};
+  // Position of the live payload in the dense index list
+  std::uint32_t dense_pos{0};
+  slot_payload<T> payload;
+
+  bool live() const noexcept {
+    return (generation & 1) != 0;
+  }
+};
+} // namespace detail
+
+/*******************************************************************************
+ *                                  Slot map                                   *
+ *******************************************************************************/
+
+// Pool of T addressed by generational handles. Insert, erase and lookup are
+// O(1); a handle to an erased element is detected as stale, even after its
+// slot has been reused. Payloads live in fixed-size chunks and never move, so
+// pointers stay valid until the element is erased. Iteration walks a dense
+// list of live slot indices, so it never visits free slots, but each element
+// is reached through its index in the chunked slot array rather than in
+// memory order. Erasing swaps the last live index into the hole.
+template <typename T>
+class slot_map {
+  using slot = detail::map_slot<T>;
+
+  static constexpr std::uint32_t chunk_bits = 8;
+  static constexpr std::uint32_t chunk_size = std::uint32_t{1} << chunk_bits;
+  static constexpr std::uint32_t no_slot =
+      std::numeric_limits<std::uint32_t>::max();
+  // A slot whose generation would wrap around is retired instead of reused
+  static constexpr std::uint32_t last_generation = no_slot - 1;
+
+public:
+  using handle = slot_handle;
+  using value_type = T;
+
+  template <bool is_const>
+  class basic_iterator;
+  using iterator = basic_iterator<false>;
+  using const_iterator = basic_iterator<true>;
+
+  slot_map() = default;
+
+  slot_map(const slot_map& other)
+      : dense{other.dense}, free_head{other.free_head},
+        slot_count{other.slot_count} {
+    chunks.reserve(other.chunks.size());
+    for (std::size_t c = 0; c < other.chunks.size(); ++c) {
+      chunks.push_back(std::make_unique<slot[]>(chunk_size));
+    }
+    std::uint32_t copied = 0;
+    try {
+      for (; copied < slot_count; ++copied) {
+        slot const& from = other.slot_at(copied);
+        slot& to = slot_at(copied);
+        if (from.live()) {
+          new (&to.payload.value) T(from.payload.value);
+        } else {
+          to.payload.next_free = from.payload.next_free;
+        }
+        to.generation = from.generation;
+        to.dense_pos = from.dense_pos;
+      }
+    } catch (...) {
+      destroy_prefix(copied);
+      throw;
+    }
+  }
+
+  slot_map(slot_map&& other) noexcept
+      : chunks{std::move(other.chunks)}, dense{std::move(other.dense)},
+        free_head{std::exchange(other.free_head, no_slot)},
+        slot_count{std::exchange(other.slot_count, 0)} {
+    other.chunks.clear();
+    other.dense.clear();
+  }
+
+  slot_map& operator=(const slot_map& other) {
+    if (this != &other) {
+      slot_map tmp{other};
+      swap(tmp);
+    }
+    return *this;
+  }
+
+  slot_map& operator=(slot_map&& other) noexcept {
+    if (this != &other) {
+      slot_map tmp{std::move(other)};
+      swap(tmp);
+    }
+    return *this;
+  }
+
+  ~slot_map() {
+    clear();
+  }
+
+  template <typename... Args>
+  handle emplace(Args&&... args) {
+    if (free_head == no_slot) {
+      grow();
+    }
+    std::uint32_t index = free_head;
+    slot& s = slot_at(index);
+    std::uint32_t next_free = s.payload.next_free;
+    // Make room before constructing, push_back below must not throw. Growing
+    // geometrically keeps a run of inserts linear.
+    if (dense.size() == dense.capacity()) {
+      dense.reserve(dense.empty() ? 8 : 2 * dense.size());
+    }
+    new (&s.payload.value) T(std::forward<Args>(args)...);
+    free_head = next_free;
+    s.generation += 1;
+    s.dense_pos = static_cast<std::uint32_t>(dense.size());
+    dense.push_back(index);
+    return {index, s.generation};
+  }
+
+  handle insert(const T& value) {
+    return emplace(value);
+  }
+
+  handle insert(T&& value) {
+    return emplace(std::move(value));
+  }
+
+  // Returns false if the handle was stale
+  bool erase(handle h) noexcept {
+    if (!contains(h)) {
+      return false;
+    }
+    slot& s = slot_at(h.index);
+    s.payload.value.~T();
+    s.generation += 1;
+
+    std::uint32_t moved = dense.back();
+    dense[s.dense_pos] = moved;
+    slot_at(moved).dense_pos = s.dense_pos;
+    dense.pop_back();
+
+    if (s.generation != last_generation) {
+      s.payload.next_free = free_head;
+      free_head = h.index;
+    }
+    return true;
+  }
+
+  bool contains(handle h) const noexcept {
+    return h.index < slot_count && (h.generation & 1) != 0 &&
+           slot_at(h.index).generation == h.generation;
+  }
+
+  T* find(handle h) noexcept {
+    return contains(h) ? &slot_at(h.index).payload.value : nullptr;
+  }
+
+  T const* find(handle h) const noexcept {
+    return contains(h) ? &slot_at(h.index).payload.value : nullptr;
+  }
+
+  // Unchecked access, the handle must be live
+  T& operator[](handle h) noexcept {
+    assert(contains(h));
+    return slot_at(h.index).payload.value;
+  }
+
+  T const& operator[](handle h) const noexcept {
+    assert(contains(h));
+    return slot_at(h.index).payload.value;
+  }
+
+  std::size_t size() const noexcept {
+    return dense.size();
+  }
+
+  bool empty() const noexcept {
+    return dense.empty();
+  }
+
+  // Erases every element; outstanding handles become stale
+  void clear() noexcept {
+    while (!dense.empty()) {
+      std::uint32_t index = dense.back();
+      erase({index, slot_at(index).generation});
+    }
+  }
+
+  iterator begin() noexcept {
+    return {this, 0};
+  }
+
+  iterator end() noexcept {
+    return {this, dense.size()};
+  }
+
+  const_iterator begin() const noexcept {
+    return {this, 0};
+  }
+
+  const_iterator end() const noexcept {
+    return {this, dense.size()};
+  }
+
+  void swap(slot_map& other) noexcept {
+    using std::swap;
+    swap(chunks, other.chunks);
+    swap(dense, other.dense);
+    swap(free_head, other.free_head);
+    swap(slot_count, other.slot_count);
+  }
+
+private:
+  slot& slot_at(std::uint32_t index) noexcept {
+    return chunks[index >> chunk_bits][index & (chunk_size - 1)];
+  }
+
+  slot const& slot_at(std::uint32_t index) const noexcept {
+    return chunks[index >> chunk_bits][index & (chunk_size - 1)];
+  }
+
+  // Puts a fresh slot on the free list, chunk allocation may throw
+  void grow() {
+    if (slot_count == chunks.size() * chunk_size) {
+      if (slot_count == no_slot - chunk_size + 1) {
+        throw std::length_error("slot_map is full");
+      }
+      chunks.push_back(std::make_unique<slot[]>(chunk_size));
+    }
+    std::uint32_t index = slot_count++;
+    slot_at(index).payload.next_free = free_head;
+    free_head = index;
+  }
+
+  // Rollback of a failed copy: slots [0, count) may hold live payloads
+  void destroy_prefix(std::uint32_t count) noexcept {
+    for (std::uint32_t i = 0; i < count; ++i) {
+      if (slot_at(i).live()) {
+        slot_at(i).payload.value.~T();
+      }
+    }
+    chunks.clear();
+    dense.clear();
+    free_head = no_slot;
+    slot_count = 0;
+  }
+
+  std::vector<std::unique_ptr<slot[]>> chunks;
+  std::vector<std::uint32_t> dense;
+  std::uint32_t free_head{no_slot};
+  std::uint32_t slot_count{0};
+};
+
+template <typename T>
+template <bool is_const>
+class slot_map<T>::basic_iterator {
+  using map_type = std::conditional_t<is_const, const slot_map, slot_map>;
+
+public:
+  using iterator_category = std::random_access_iterator_tag;
+  using value_type = T;
+  using difference_type = std::ptrdiff_t;
+  using reference = std::conditional_t<is_const, T const&, T&>;
+  using pointer = std::conditional_t<is_const, T const*, T*>;
+
+  basic_iterator() = default;
+
+  basic_iterator(map_type* map_, std::size_t pos_) noexcept
+      : map{map_}, pos{pos_} {}
+
+  // Non-const to const conversion
+  template <bool other_const,
+            typename = std::enable_if_t<is_const && !other_const>>
+  basic_iterator(const basic_iterator<other_const>& other) noexcept
+      : map{other.map}, pos{other.pos} {}
+
+  reference operator*() const noexcept {
+    return map->slot_at(map->dense[pos]).payload.value;
+  }
+
+  pointer operator->() const noexcept {
+    return &**this;
+  }
+
+  reference operator[](difference_type n) const noexcept {
+    return *(*this + n);
+  }
+
+  // Handle of the element the iterator points to
+  slot_handle handle() const noexcept {
+    std::uint32_t index = map->dense[pos];
+    return {index, map->slot_at(index).generation};
+  }
+
+  basic_iterator& operator++() noexcept {
+    ++pos;
+    return *this;
+  }
+
+  basic_iterator operator++(int) noexcept {
+    basic_iterator old = *this;
+    ++pos;
+    return old;
+  }
+
+  basic_iterator& operator--() noexcept {
+    --pos;
+    return *this;
+  }
+
+  basic_iterator operator--(int) noexcept {
+    basic_iterator old = *this;
+    --pos;
+    return old;
+  }
+
+  basic_iterator& operator+=(difference_type n) noexcept {
+    pos += n;
+    return *this;
+  }
+
+  basic_iterator& operator-=(difference_type n) noexcept {
+    pos -= n;
+    return *this;
+  }
+
+  friend basic_iterator operator+(basic_iterator it,
+                                  difference_type n) noexcept {
+    return it += n;
+  }
+
+  friend basic_iterator operator+(difference_type n,
+                                  basic_iterator it) noexcept {
+    return it += n;
+  }
+
+  friend basic_iterator operator-(basic_iterator it,
+                                  difference_type n) noexcept {
+    return it -= n;
+  }
+
+  friend difference_type operator-(const basic_iterator& a,
+                                   const basic_iterator& b) noexcept {
+    return static_cast<difference_type>(a.pos) -
+           static_cast<difference_type>(b.pos);
+  }
+
+  friend bool operator==(const basic_iterator& a,
+                         const basic_iterator& b) noexcept {
+    return a.pos == b.pos;
+  }
+
+  friend auto operator<=>(const basic_iterator& a,
+                          const basic_iterator& b) noexcept {
+    return a.pos <=> b.pos;
+  }
+
+private:
+  template <bool>
+  friend class basic_iterator;
+
+  map_type* map{nullptr};
+  std::size_t pos{0};
+};
+
+template <typename T>
+void swap(slot_map<T>& a, slot_map<T>& b) noexcept {
+  a.swap(b);
+}
@@ -0,0 +1,137 @@
+#include "slot_map.h"
+#include <benchmark/benchmark.h>
+#include <cstdint>
+#include <random>
+#include <unordered_map>
+#include <vector>
+
+// Entity pool workloads: slot_map handles against an unordered_map keyed by
+// a running id.
+
+namespace {
+struct entity {
+  float position[3];
+  float velocity[3];
+  std::uint32_t flags;
+};
+
+constexpr int pool_size = 100'000;
+} // namespace
+
+static void BM_slot_map_fill(benchmark::State& state) {
+  for (auto _ : state) {
+    slot_map<entity> pool;
+    for (int i = 0; i < pool_size; ++i) {
+      benchmark::DoNotOptimize(pool.insert(entity{}));
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * pool_size);
+}
+BENCHMARK(BM_slot_map_fill);
+
+static void BM_unordered_map_fill(benchmark::State& state) {
+  for (auto _ : state) {
+    std::unordered_map<std::uint64_t, entity> pool;
+    for (int i = 0; i < pool_size; ++i) {
+      benchmark::DoNotOptimize(pool.emplace(i, entity{}));
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * pool_size);
+}
+BENCHMARK(BM_unordered_map_fill);
+
+static void BM_slot_map_churn(benchmark::State& state) {
+  slot_map<entity> pool;
+  std::vector<slot_handle> handles;
+  for (int i = 0; i < pool_size; ++i) {
+    handles.push_back(pool.insert(entity{}));
+  }
+  std::mt19937 rng(1);
+  for (auto _ : state) {
+    auto& h = handles[rng() % pool_size];
+    pool.erase(h);
+    h = pool.insert(entity{});
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_slot_map_churn);
+
+static void BM_unordered_map_churn(benchmark::State& state) {
+  std::unordered_map<std::uint64_t, entity> pool;
+  std::vector<std::uint64_t> ids;
+  std::uint64_t next_id = 0;
+  for (int i = 0; i < pool_size; ++i) {
+    ids.push_back(next_id);
+    pool.emplace(next_id++, entity{});
+  }
+  std::mt19937 rng(1);
+  for (auto _ : state) {
+    auto& id = ids[rng() % pool_size];
+    pool.erase(id);
+    id = next_id++;
+    pool.emplace(id, entity{});
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_unordered_map_churn);
+
+static void BM_slot_map_lookup(benchmark::State& state) {
+  slot_map<entity> pool;
+  std::vector<slot_handle> handles;
+  for (int i = 0; i < pool_size; ++i) {
+    handles.push_back(pool.insert(entity{}));
+  }
+  std::mt19937 rng(2);
+  for (auto _ : state) {
+    entity* e = pool.find(handles[rng() % pool_size]);
+    benchmark::DoNotOptimize(e->flags += 1);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_slot_map_lookup);
+
+static void BM_unordered_map_lookup(benchmark::State& state) {
+  std::unordered_map<std::uint64_t, entity> pool;
+  for (int i = 0; i < pool_size; ++i) {
+    pool.emplace(i, entity{});
+  }
+  std::mt19937 rng(2);
+  for (auto _ : state) {
+    auto it = pool.find(rng() % pool_size);
+    benchmark::DoNotOptimize(it->second.flags += 1);
+  }
+  state.SetItemsProcessed(state.iterations());
+}
+BENCHMARK(BM_unordered_map_lookup);
+
+static void BM_slot_map_iterate(benchmark::State& state) {
+  slot_map<entity> pool;
+  for (int i = 0; i < pool_size; ++i) {
+    pool.insert(entity{});
+  }
+  for (auto _ : state) {
+    for (entity& e : pool) {
+      e.position[0] += e.velocity[0];
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * pool_size);
+}
+BENCHMARK(BM_slot_map_iterate);
+
+static void BM_unordered_map_iterate(benchmark::State& state) {
+  std::unordered_map<std::uint64_t, entity> pool;
+  for (int i = 0; i < pool_size; ++i) {
+    pool.emplace(i, entity{});
+  }
+  for (auto _ : state) {
+    for (auto& [id, e] : pool) {
+      e.position[0] += e.velocity[0];
+    }
+    benchmark::ClobberMemory();
+  }
+  state.SetItemsProcessed(state.iterations() * pool_size);
+}
+BENCHMARK(BM_unordered_map_iterate);
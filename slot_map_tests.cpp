@@ -0,0 +1,121 @@
+#include "slot_map.h"
+#include "test_object.h"
+#include "gtest/gtest.h"
+#include <algorithm>
+#include <memory>
+#include <string>
+
+TEST(slot_map_testing, insert_and_find) {
+  slot_map<std::string> m;
+  auto a = m.insert("a");
+  auto b = m.emplace(3, 'b');
+  EXPECT_EQ(2, m.size());
+  EXPECT_EQ("a", m[a]);
+  ASSERT_NE(nullptr, m.find(b));
+  EXPECT_EQ("bbb", *m.find(b));
+  EXPECT_TRUE(m.contains(a));
+  EXPECT_NE(a, b);
+}
+
+TEST(slot_map_testing, stale_handle) {
+  slot_map<int> m;
+  auto a = m.insert(1);
+  EXPECT_TRUE(m.erase(a));
+  EXPECT_FALSE(m.contains(a));
+  EXPECT_EQ(nullptr, m.find(a));
+  EXPECT_FALSE(m.erase(a));
+
+  auto b = m.insert(2);
+  EXPECT_EQ(a.index, b.index);
+  EXPECT_NE(a.generation, b.generation);
+  EXPECT_FALSE(m.contains(a));
+  EXPECT_EQ(2, m[b]);
+}
+
+TEST(slot_map_testing, foreign_handles) {
+  slot_map<int> m;
+  EXPECT_FALSE(m.contains({0, 1}));
+  EXPECT_FALSE(m.contains({100, 1}));
+  auto a = m.insert(1);
+  EXPECT_FALSE(m.contains({a.index, a.generation + 1}));
+  EXPECT_FALSE(m.contains({a.index, 0}));
+}
+
+TEST(slot_map_testing, stable_addresses) {
+  slot_map<int> m;
+  auto first = m.insert(0);
+  int* p = m.find(first);
+  for (int i = 1; i < 10'000; ++i) {
+    m.insert(i);
+  }
+  EXPECT_EQ(p, m.find(first));
+  EXPECT_EQ(0, *p);
+}
+
+TEST(slot_map_testing, dense_iteration) {
+  slot_map<int> m;
+  std::vector<slot_handle> handles;
+  for (int i = 0; i < 10; ++i) {
+    handles.push_back(m.insert(i));
+  }
+  for (int i = 0; i < 10; i += 2) {
+    m.erase(handles[i]);
+  }
+  std::vector<int> values(m.begin(), m.end());
+  std::sort(values.begin(), values.end());
+  EXPECT_EQ((std::vector<int>{1, 3, 5, 7, 9}), values);
+  for (auto it = m.begin(); it != m.end(); ++it) {
+    EXPECT_EQ(*it, m[it.handle()]);
+  }
+  EXPECT_EQ(5, std::as_const(m).end() - std::as_const(m).begin());
+}
+
+TEST(slot_map_testing, lifetimes) {
+  test_object::no_new_instances_guard g;
+  {
+    slot_map<test_object> m;
+    auto a = m.emplace(1);
+    auto b = m.emplace(2);
+    m.emplace(3);
+    m.erase(b);
+    slot_map<test_object> copy = m;
+    EXPECT_EQ(1, copy[a]);
+    EXPECT_FALSE(copy.contains(b));
+    slot_map<test_object> moved = std::move(copy);
+    EXPECT_EQ(2, moved.size());
+    m = moved;
+    m.clear();
+    EXPECT_TRUE(m.empty());
+    EXPECT_FALSE(m.contains(a));
+  }
+  g.expect_no_instances();
+}
+
+TEST(slot_map_testing, move_only_payload) {
+  slot_map<std::unique_ptr<int>> m;
+  auto a = m.emplace(std::make_unique<int>(5));
+  slot_map<std::unique_ptr<int>> n = std::move(m);
+  EXPECT_EQ(5, *n[a]);
+  EXPECT_TRUE(m.empty());
+}
+
+namespace {
+struct throwing_ctor {
+  explicit throwing_ctor(bool fail) {
+    if (fail) {
+      throw std::exception();
+    }
+  }
+};
+} // namespace
+
+TEST(slot_map_testing, throwing_emplace_keeps_map_intact) {
+  slot_map<throwing_ctor> m;
+  auto a = m.emplace(false);
+  EXPECT_THROW(m.emplace(true), std::exception);
+  EXPECT_EQ(1, m.size());
+  EXPECT_TRUE(m.contains(a));
+  auto b = m.emplace(false);
+  EXPECT_TRUE(m.contains(b));
+  EXPECT_EQ(2, m.size());
+}
@@ -0,0 +1,70 @@
+#include "optional.h"
+#include <benchmark/benchmark.h>
+#include <optional>
+#include <string>
+#include <vector>
+
+// Calling an API that takes `const std::optional<T>&` with our optional:
+// through the converting operator (a payload copy per call) against the
+// borrowed `as_std` view.
+
+namespace {
+constexpr const char* long_text = "a payload that does not fit in the SSO";
+
+[[gnu::noinline]] std::size_t std_api(const std::optional<std::string>& s) {
+  return s ? s->size() : 0;
+}
+
+std::vector<optional<std::string>> make_rows(std::size_t count) {
+  std::vector<optional<std::string>> rows(count);
+  for (std::size_t i = 0; i < count; i += 2) {
+    rows[i] = long_text;
+  }
+  return rows;
+}
+} // namespace
+
+static void BM_std_boundary_convert(benchmark::State& state) {
+  auto rows = make_rows(state.range(0));
+  for (auto _ : state) {
+    std::size_t total = 0;
+    for (auto const& row : rows) {
+      total += std_api(row);
+    }
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_std_boundary_convert)->Arg(1 << 10)->Arg(1 << 16);
+
+static void BM_std_boundary_view(benchmark::State& state) {
+  auto rows = make_rows(state.range(0));
+  for (auto _ : state) {
+    std::size_t total = 0;
+    for (auto const& row : rows) {
+      total += std_api(as_std(row));
+    }
+    benchmark::DoNotOptimize(total);
+  }
+  state.SetItemsProcessed(state.iterations() * state.range(0));
+}
+BENCHMARK(BM_std_boundary_view)->Arg(1 << 10)->Arg(1 << 16);
+
+// Handing ownership over: the moving conversion against a copy
+static void BM_std_handoff_move(benchmark::State& state) {
+  for (auto _ : state) {
+    optional<std::string> ours(long_text);
+    std::optional<std::string> theirs = std::move(ours);
+    benchmark::DoNotOptimize(theirs);
+  }
+}
+BENCHMARK(BM_std_handoff_move);
+
+static void BM_std_handoff_copy(benchmark::State& state) {
+  for (auto _ : state) {
+    optional<std::string> ours(long_text);
+    std::optional<std::string> theirs = ours;
+    benchmark::DoNotOptimize(theirs);
+  }
+}
+BENCHMARK(BM_std_handoff_copy);
@@ -0,0 +1,123 @@
+#include "optional.h"
+#include "test_classes.h"
+#include "gtest/gtest.h"
+#include <cstring>
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+constexpr const char* long_string =
+    "a string that is long enough to not fit into the small buffer";
+
+std::size_t std_length(const std::optional<std::string>& s) {
+  return s ? s->size() : 0;
+}
+
+std::size_t length(const optional<std::string>& s) {
+  return s ? s->size() : 0;
+}
+
+template <typename Opt>
+unsigned char flag_byte(const Opt& o, std::size_t offset) {
+  unsigned char byte;
+  std::memcpy(&byte, reinterpret_cast<const unsigned char*>(&o) + offset, 1);
+  return byte;
+}
+
+// The engaged flag of both types is the byte right after the payload
+template <typename T>
+void expect_flag_after_payload(T const& value) {
+  optional<T> ours(value), ours_empty;
+  std::optional<T> theirs(value), theirs_empty;
+  EXPECT_EQ(1, flag_byte(ours, sizeof(T)));
+  EXPECT_EQ(1, flag_byte(theirs, sizeof(T)));
+  EXPECT_EQ(0, flag_byte(ours_empty, sizeof(T)));
+  EXPECT_EQ(0, flag_byte(theirs_empty, sizeof(T)));
+}
+} // namespace
+
+static_assert(detail::std_flag_follows_payload);
+static_assert(detail::std_layout_compatible<int>);
+static_assert(detail::std_layout_compatible<double>);
+static_assert(detail::std_layout_compatible<std::string>);
+static_assert(detail::std_layout_compatible<std::vector<int>>);
+
+TEST(std_interop_testing, flag_offset) {
+  expect_flag_after_payload<unsigned char>(0);
+  expect_flag_after_payload<int>(0);
+  expect_flag_after_payload<double>(0.0);
+  expect_flag_after_payload<std::string>(long_string);
+}
+
+TEST(std_interop_testing, from_std) {
+  std::optional<std::string> s(long_string), empty;
+  optional<std::string> a = s;
+  optional<std::string> b = empty;
+  EXPECT_EQ(long_string, *a);
+  EXPECT_EQ(long_string, *s);
+  EXPECT_FALSE(static_cast<bool>(b));
+}
+
+TEST(std_interop_testing, from_std_moves) {
+  counting_t::count = {};
+  std::optional<counting_t> s(std::in_place, "text");
+  optional<counting_t> a = std::move(s);
+  EXPECT_EQ("text", a->text);
+  EXPECT_EQ(1, counting_t::count.moved);
+  EXPECT_EQ(0, counting_t::count.copied);
+}
+
+TEST(std_interop_testing, to_std) {
+  optional<std::string> a(long_string), empty;
+  std::optional<std::string> s = a;
+  std::optional<std::string> t = empty;
+  EXPECT_EQ(long_string, *s);
+  EXPECT_EQ(long_string, *a);
+  EXPECT_FALSE(t.has_value());
+  EXPECT_EQ(std::string(long_string).size(), std_length(a));
+}
+
+TEST(std_interop_testing, to_std_moves) {
+  counting_t::count = {};
+  optional<counting_t> a(in_place, "text");
+  std::optional<counting_t> s = std::move(a);
+  EXPECT_EQ("text", s->text);
+  EXPECT_EQ(1, counting_t::count.moved);
+  EXPECT_EQ(0, counting_t::count.copied);
+}
+
+TEST(std_interop_testing, assignment_from_std) {
+  optional<std::string> a("old");
+  a = std::optional<std::string>(long_string);
+  EXPECT_EQ(long_string, *a);
+  a = std::optional<std::string>();
+  EXPECT_FALSE(static_cast<bool>(a));
+}
+
+TEST(std_interop_testing, as_std_views) {
+  optional<std::string> a(long_string), empty;
+  const std::optional<std::string>& s = as_std(a);
+  EXPECT_EQ(static_cast<const void*>(&a), static_cast<const void*>(&s));
+  ASSERT_TRUE(s.has_value());
+  EXPECT_EQ(a->data(), s->data());
+  EXPECT_FALSE(as_std(empty).has_value());
+  EXPECT_EQ(std::string(long_string).size(), std_length(as_std(a)));
+
+  a.reset();
+  EXPECT_FALSE(s.has_value());
+}
+
+TEST(std_interop_testing, as_optional_views) {
+  std::optional<std::string> s(long_string), empty;
+  const optional<std::string>& a = as_optional(s);
+  ASSERT_TRUE(static_cast<bool>(a));
+  EXPECT_EQ(s->data(), a->data());
+  EXPECT_FALSE(static_cast<bool>(as_optional(empty)));
+  EXPECT_EQ(std::string(long_string).size(), length(as_optional(s)));
+
+  std::optional<int> i(7);
+  EXPECT_EQ(7, *as_optional(i));
+  i = 8;
+  EXPECT_EQ(8, *as_optional(i));
+}
@@ -1,6 +1,12 @@
 #pragma once
 
 #include "gtest/gtest.h"
+#include <array>
+#include <cstddef>
+#include <memory>
+#include <string>
+#include <string_view>
+#include <vector>
 
 struct dummy_t {};
 
@@ -25,7 +31,7 @@ struct throwing_move_operator_t {
 
 inline size_t throwing_move_operator_t::swap_called = 0;
 
-void swap(throwing_move_operator_t&, throwing_move_operator_t&) {
+inline void swap(throwing_move_operator_t&, throwing_move_operator_t&) {
   throwing_move_operator_t::swap_called += 1;
 }
 
@@ -65,3 +71,91 @@ struct no_move_assignment_t {
 struct no_copy_assignment_t {
   no_copy_assignment_t& operator=(const no_copy_assignment_t&) = delete;
 };
+
+// Records how each instance was built, so that tests can check that no
+// temporaries are created on the way into an optional
+struct counting_t {
+  struct counters {
+    size_t converted = 0;
+    size_t copied = 0;
+    size_t moved = 0;
+    size_t converting_assigned = 0;
+    size_t copy_assigned = 0;
+    size_t move_assigned = 0;
+  };
+
+  static counters count;
+
+  counting_t(const char* text_) : text{text_} {
+    count.converted += 1;
+  }
+
+  counting_t(std::string_view text_) : text{text_} {
+    count.converted += 1;
+  }
+
+  counting_t(const counting_t& other) : text{other.text} {
+    count.copied += 1;
+  }
+
+  counting_t(counting_t&& other) noexcept : text{std::move(other.text)} {
+    count.moved += 1;
+  }
+
+  counting_t& operator=(const char* text_) {
+    text = text_;
+    count.converting_assigned += 1;
+    return *this;
+  }
+
+  counting_t& operator=(std::string_view text_) {
+    text = text_;
+    count.converting_assigned += 1;
+    return *this;
+  }
+
+  counting_t& operator=(const counting_t& other) {
+    text = other.text;
+    count.copy_assigned += 1;
+    return *this;
+  }
+
+  counting_t& operator=(counting_t&& other) noexcept {
+    text = std::move(other.text);
+    count.move_assigned += 1;
+    return *this;
+  }
+
+  std::string text;
+};
+
+inline counting_t::counters counting_t::count{};
+
+struct explicit_from_int_t {
+  explicit explicit_from_int_t(int x_) : x{x_} {}
+
+  int x;
+};
+
+struct trivial_aggregate_t {
+  int x;
+  float y;
+};
+
+enum class trivial_enum_t : unsigned char { first, second };
+
+template <typename... Ts>
+struct type_list {};
+
+// Payloads whose `optional` must stay trivially copyable and therefore be
+// passed in registers under the Itanium ABI
+using trivial_payload_types =
+    type_list<char, bool, int, unsigned, long long, float, double, void*,
+              int const*, std::nullptr_t, std::byte, trivial_enum_t, dummy_t,
+              trivial_aggregate_t, std::array<int, 4>, std::string_view>;
+
+using non_trivial_payload_types =
+    type_list<std::string, std::vector<int>, std::unique_ptr<int>, no_copy_t,
+              no_move_t, non_trivial_copy_t, non_trivial_copy_assignment_t,
+              no_move_assignment_t, no_copy_assignment_t,
+              throwing_move_operator_t>;
@@ -2,8 +2,10 @@
 #include "test_classes.h"
 #include "test_object.h"
 #include "gtest/gtest.h"
+#include <memory>
 #include <stdexcept>
 #include <string>
+#include <utility>
 #include <vector>
 
 namespace {
@@ -183,6 +185,20 @@ TEST(optional_testing, emplace) {
   a.emplace(1, 2, 3, std::unique_ptr<int>());
   EXPECT_TRUE(static_cast<bool>(a));
 }
+
+// Like std::optional::emplace the payload is direct-initialized, so an
+// initializer_list constructor is not preferred and narrowing is allowed
+TEST(optional_testing, emplace_direct_init) {
+  optional<std::string> a;
+  a.emplace(3, 'x');
+  EXPECT_EQ("xxx", *a);
+  optional<std::vector<int>> b;
+  b.emplace(2, 5);
+  EXPECT_EQ((std::vector<int>{5, 5}), *b);
+  optional<int> c;
+  c.emplace(7.0);
+  EXPECT_EQ(7, *c);
+}
 namespace {
 struct throw_in_ctor {
   struct exception : std::exception {
@@ -205,6 +221,197 @@ TEST(optional_testing, emplace_throw) {
   EXPECT_FALSE(static_cast<bool>(a));
 }
 
+TEST(optional_testing, converting_ctor_no_temporary) {
+  counting_t::count = {};
+  optional<counting_t> a = "literal";
+  optional<counting_t> b(std::string_view("view"));
+  EXPECT_EQ("literal", a->text);
+  EXPECT_EQ("view", b->text);
+  EXPECT_EQ(2, counting_t::count.converted);
+  EXPECT_EQ(0, counting_t::count.copied);
+  EXPECT_EQ(0, counting_t::count.moved);
+}
+
+TEST(optional_testing, converting_assignment_no_temporary) {
+  counting_t::count = {};
+  optional<counting_t> a;
+  a = "first";
+  EXPECT_EQ(1, counting_t::count.converted);
+  a = std::string_view("second");
+  EXPECT_EQ(1, counting_t::count.converting_assigned);
+  EXPECT_EQ("second", a->text);
+  EXPECT_EQ(0, counting_t::count.copied);
+  EXPECT_EQ(0, counting_t::count.moved);
+  EXPECT_EQ(0, counting_t::count.move_assigned);
+}
+
+TEST(optional_testing, converting_ctor_from_optional) {
+  counting_t::count = {};
+  optional<std::string_view> a("text"), empty;
+  optional<counting_t> b = a;
+  optional<counting_t> c = std::move(a);
+  optional<counting_t> d = empty;
+  EXPECT_EQ("text", b->text);
+  EXPECT_EQ("text", c->text);
+  EXPECT_FALSE(static_cast<bool>(d));
+  EXPECT_EQ(2, counting_t::count.converted);
+  EXPECT_EQ(0, counting_t::count.moved);
+
+  optional<int> i(5);
+  optional<long long> l = i;
+  EXPECT_EQ(5, *l);
+}
+
+TEST(optional_testing, converting_assignment_from_optional) {
+  test_object::no_new_instances_guard g;
+  optional<test_object> a(1), b;
+  optional<int> value(42), empty;
+  a = value;
+  b = std::move(value);
+  EXPECT_EQ(42, *a);
+  EXPECT_EQ(42, *b);
+  a = empty;
+  EXPECT_FALSE(static_cast<bool>(a));
+}
+
+TEST(optional_testing, converting_ctor_explicitness) {
+  EXPECT_TRUE((std::is_constructible_v<optional<explicit_from_int_t>, int>));
+  EXPECT_FALSE((std::is_convertible_v<int, optional<explicit_from_int_t>>));
+  EXPECT_TRUE((std::is_constructible_v<optional<explicit_from_int_t>,
+                                       optional<int> const&>));
+  EXPECT_FALSE((std::is_convertible_v<optional<int> const&,
+                                      optional<explicit_from_int_t>>));
+  EXPECT_TRUE((std::is_convertible_v<const char*, optional<std::string>>));
+  EXPECT_TRUE((std::is_convertible_v<optional<const char*>,
+                                     optional<std::string>>));
+  EXPECT_FALSE((std::is_constructible_v<optional<int>, std::string>));
+}
+
+TEST(optional_testing, brace_assignment_resets) {
+  optional<int> a(5);
+  a = {};
+  EXPECT_FALSE(static_cast<bool>(a));
+}
+
+TEST(optional_testing, take) {
+  test_object::no_new_instances_guard g;
+  optional<test_object> a(42);
+  test_object v = a.take();
+  EXPECT_EQ(42, v);
+  EXPECT_FALSE(static_cast<bool>(a));
+
+  optional<std::unique_ptr<int>> p(std::make_unique<int>(7));
+  std::unique_ptr<int> q = p.take();
+  EXPECT_EQ(7, *q);
+  EXPECT_FALSE(static_cast<bool>(p));
+}
+
+TEST(optional_testing, exchange) {
+  test_object::no_new_instances_guard g;
+  optional<test_object> a(1);
+  optional<test_object> old = a.exchange(2);
+  EXPECT_EQ(1, *old);
+  EXPECT_EQ(2, *a);
+
+  optional<test_object> empty;
+  old = empty.exchange(3);
+  EXPECT_FALSE(static_cast<bool>(old));
+  EXPECT_EQ(3, *empty);
+}
+
+namespace {
+struct positive_t {
+  positive_t(int value_) : value{value_} {
+    if (value <= 0)
+      throw std::invalid_argument("not positive");
+  }
+
+  int value;
+};
+} // namespace
+
+// The new payload is built before the old one is given up
+TEST(optional_testing, exchange_builds_first) {
+  test_object::no_new_instances_guard g;
+  optional<test_object> a(1);
+  optional<test_object> old = a.exchange(*a);
+  EXPECT_EQ(1, *old);
+  EXPECT_EQ(1, *a);
+
+  optional<positive_t> b(in_place, 1);
+  EXPECT_THROW(b.exchange(-1), std::invalid_argument);
+  ASSERT_TRUE(static_cast<bool>(b));
+  EXPECT_EQ(1, b->value);
+}
+
+namespace {
+// Counts moves and destructions, relocation must do neither
+struct relocatable_t {
+  explicit relocatable_t(int value_) : value{new int(value_)} {}
+
+  relocatable_t(relocatable_t&& other) noexcept
+      : value{std::exchange(other.value, nullptr)} {
+    ++moved;
+  }
+
+  relocatable_t& operator=(relocatable_t&& other) noexcept {
+    std::swap(value, other.value);
+    return *this;
+  }
+
+  ~relocatable_t() {
+    ++destroyed;
+    delete value;
+  }
+
+  int* value;
+
+  static inline int moved = 0;
+  static inline int destroyed = 0;
+};
+} // namespace
+
+template <>
+struct is_trivially_relocatable<relocatable_t> : std::true_type {};
+
+TEST(optional_testing, exchange_relocates) {
+  relocatable_t::moved = relocatable_t::destroyed = 0;
+  {
+    optional<relocatable_t> a(in_place, 1);
+    optional<relocatable_t> old = a.exchange(relocatable_t(2));
+    EXPECT_EQ(1, *old->value);
+    EXPECT_EQ(2, *a->value);
+    // Only the temporary argument is moved from and destroyed
+    EXPECT_EQ(1, relocatable_t::moved);
+    EXPECT_EQ(1, relocatable_t::destroyed);
+  }
+  EXPECT_EQ(3, relocatable_t::destroyed);
+}
+
+TEST(optional_testing, swap_one_sided_relocates) {
+  relocatable_t::moved = relocatable_t::destroyed = 0;
+  optional<relocatable_t> a(in_place, 1), b;
+  a.swap(b);
+  EXPECT_FALSE(static_cast<bool>(a));
+  EXPECT_EQ(1, *b->value);
+  b.swap(a);
+  EXPECT_EQ(1, *a->value);
+  EXPECT_FALSE(static_cast<bool>(b));
+  EXPECT_EQ(0, relocatable_t::moved);
+  EXPECT_EQ(0, relocatable_t::destroyed);
+}
+
+TEST(optional_testing, swap_one_sided) {
+  test_object::no_new_instances_guard g;
+  optional<test_object> a(5), b;
+  a.swap(b);
+  EXPECT_FALSE(static_cast<bool>(a));
+  EXPECT_EQ(5, *b);
+  b.swap(a);
+  EXPECT_EQ(5, *a);
+  EXPECT_FALSE(static_cast<bool>(b));
+}
+
 TEST(optional_testing, comparison_non_empty_and_non_empty) {
   optional<int> a(41), b(42);
   EXPECT_FALSE(a == b);
@@ -289,6 +496,17 @@ struct cvalue {
 private:
   int value;
 };
+
+// Non-trivially destructible, but still usable in constant expressions
+struct cdestructible {
+  constexpr cdestructible(int value_) : value(value_) {}
+
+  constexpr ~cdestructible() {
+    value = -1;
+  }
+
+  int value;
+};
 } // namespace
 
 TEST(traits, destructor) {
@@ -457,3 +675,81 @@ static_assert([] {
   a = std::move(b);
   return *a == 42;
 }());
+
+static_assert([] {
+  optional<cvalue> a(42);
+  optional<cvalue> b(a);
+  a.reset();
+  return !a && b->get() == 42;
+}());
+
+static_assert([] {
+  optional<cvalue> a;
+  a.emplace(7);
+  return a->get() == 7;
+}());
+
+static_assert([] {
+  optional<cdestructible> a(1);
+  a.reset();
+  a.emplace(2);
+  optional<cdestructible> b(std::move(a));
+  a = nullopt;
+  return !a && b->value == 2;
+}());
+
+namespace {
+template <typename T>
+constexpr bool passed_in_registers =
+    std::is_trivially_copyable_v<optional<T>> &&
+    std::is_trivially_destructible_v<optional<T>> &&
+    std::is_trivially_copy_constructible_v<optional<T>> &&
+    std::is_trivially_move_constructible_v<optional<T>>;
+
+template <typename T>
+constexpr bool propagates_triviality =
+    std::is_trivially_destructible_v<optional<T>> ==
+        std::is_trivially_destructible_v<T> &&
+    std::is_trivially_copy_constructible_v<optional<T>> ==
+        std::is_trivially_copy_constructible_v<T> &&
+    std::is_trivially_move_constructible_v<optional<T>> ==
+        std::is_trivially_move_constructible_v<T> &&
+    std::is_trivially_copy_assignable_v<optional<T>> ==
+        (std::is_trivially_copy_assignable_v<T> &&
+         std::is_trivially_copy_constructible_v<T>) &&
+    std::is_trivially_move_assignable_v<optional<T>> ==
+        (std::is_trivially_move_assignable_v<T> &&
+         std::is_trivially_move_constructible_v<T>);
+
+template <typename... Ts>
+constexpr bool all_passed_in_registers(type_list<Ts...>) {
+  return (passed_in_registers<Ts> && ...);
+}
+
+template <typename... Ts>
+constexpr bool none_passed_in_registers(type_list<Ts...>) {
+  return (!passed_in_registers<Ts> && ...);
+}
+
+template <typename... Ts>
+constexpr bool all_propagate_triviality(type_list<Ts...>) {
+  return (propagates_triviality<Ts> && ...);
+}
+} // namespace
+
+static_assert(all_passed_in_registers(trivial_payload_types{}));
+static_assert(none_passed_in_registers(non_trivial_payload_types{}));
+static_assert(all_propagate_triviality(trivial_payload_types{}));
+static_assert(all_propagate_triviality(non_trivial_payload_types{}));
+
+static_assert([] {
+  optional<int> a(42);
+  optional<long long> b(a);
+  return *b == 42;
+}());
+
+static_assert([] {
+  optional<cvalue> a;
+  a = 42;
+  return a->get() == 42;
+}());